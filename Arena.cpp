@@ -0,0 +1,56 @@
+/*
+ * Arena.cpp
+ *
+ * CSC 446 - Compiler Construction - Bump Allocator Implementation
+ *
+ * Author: Landon Dahmen
+ *
+ * Description:
+ *   This file implements the Arena class declared in Arena.h.
+ */
+#include <cstring>
+#include "Arena.h"
+
+using namespace std;
+
+Arena::Arena(size_t chunkSize) : chunkSize(chunkSize)
+{
+}
+
+Arena::~Arena()
+{
+    for (Chunk& chunk : chunks) {
+        delete[] chunk.data;
+    }
+}
+
+void* Arena::Allocate(size_t bytes, size_t align)
+{
+    for (;;) {
+        if (current < chunks.size()) {
+            size_t start = (used + align - 1) & ~(align - 1);
+            if (start + bytes <= chunks[current].size) {
+                used = start + bytes;
+                return chunks[current].data + start;
+            }
+            if (current + 1 < chunks.size()) {
+                // reuse a chunk left over from an earlier Reset
+                current++;
+                used = 0;
+                continue;
+            }
+        }
+        // operator new[] memory is aligned for any fundamental type
+        size_t size = bytes > chunkSize ? bytes : chunkSize;
+        chunks.push_back({new char[size], size});
+        current = chunks.size() - 1;
+        used = 0;
+    }
+}
+
+string_view Arena::Copy(string_view text)
+{
+    char* copy = static_cast<char*>(Allocate(text.size(), 1));
+    memcpy(copy, text.data(), text.size());
+    return string_view(copy, text.size());
+}
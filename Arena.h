@@ -0,0 +1,65 @@
+/*
+ * Arena.h
+ *
+ * CSC 446 - Compiler Construction - Bump Allocator Header
+ *
+ * Author: Landon Dahmen
+ *
+ * Description:
+ *   This header file declares the Arena class, a bump allocator that hands
+ *   out memory from large chunks. Nothing is freed one object at a time:
+ *   Top() marks the current position and Reset(mark) releases everything
+ *   allocated since, in O(1). The chunks are kept for reuse, so a program
+ *   that enters and leaves scopes settles into making no further calls to
+ *   the heap. All chunks are freed when the arena is destroyed.
+ *
+ *   Objects placed in an arena never have their destructors run, so only
+ *   trivially destructible types may be allocated with New.
+ */
+#ifndef _ARENA_H
+#define _ARENA_H
+#include <cstddef>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+using namespace std;
+
+class Arena {
+    public:
+        struct Mark {
+            size_t chunk;
+            size_t used;
+        };
+
+        explicit Arena(size_t chunkSize = 16 * 1024);
+        ~Arena();
+
+        void* Allocate(size_t bytes, size_t align);
+        template <typename T>
+        T* New()
+        {
+            static_assert(is_trivially_destructible<T>::value, "arena objects are never destroyed");
+            return new (Allocate(sizeof(T), alignof(T))) T();
+        }
+        string_view Copy(string_view text);     // the copy lives as long as the arena
+
+        Mark Top() const { return {current, used}; }
+        void Reset(Mark mark) { current = mark.chunk; used = mark.used; }
+        size_t ChunkCount() const { return chunks.size(); }
+
+    private:
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+
+        struct Chunk {
+            char* data;
+            size_t size;
+        };
+        vector<Chunk> chunks;
+        size_t current = 0;     // chunk being filled
+        size_t used = 0;        // bytes used in that chunk
+        size_t chunkSize;
+};
+#endif
@@ -0,0 +1,94 @@
+/*
+ * Ast.cpp
+ *
+ * CSC 446 - Compiler Construction - Abstract Syntax Tree Implementation
+ *
+ * Author: Landon Dahmen
+ *
+ * Description:
+ *   This file implements the Ast class declared in Ast.h.
+ */
+#include "Ast.h"
+
+using namespace std;
+
+Ast::Ast()
+{
+    Clear();
+}
+
+NodeIndex Ast::Add(NodeKind kind, NodeIndex left, NodeIndex right, uint8_t flags)
+{
+    AstNode node;
+    node.kind = kind;
+    node.flags = flags;
+    node.value = 0;
+    node.left = left;
+    node.right = right;
+    node.next = noNode;
+    node.entry = nullptr;
+    nodes.push_back(node);
+    return static_cast<NodeIndex>(nodes.size() - 1);
+}
+
+NodeIndex Ast::AddEntry(NodeKind kind, const TableEntry* entry, NodeIndex left)
+{
+    NodeIndex i = Add(kind, left);
+    nodes[i].entry = entry;
+    return i;
+}
+
+NodeIndex Ast::AddText(NodeKind kind, string_view value, NodeIndex left, NodeIndex right)
+{
+    NodeIndex i = Add(kind, left, right);
+    nodes[i].text.offset = static_cast<uint32_t>(text.size());
+    nodes[i].text.length = static_cast<uint32_t>(value.size());
+    text.append(value);
+    return i;
+}
+
+NodeIndex Ast::AddNumber(string_view value, int16_t number)
+{
+    NodeIndex i = AddText(numberNode, value);
+    nodes[i].flags = foldable;
+    nodes[i].value = number;
+    return i;
+}
+
+NodeIndex Ast::AddIf(NodeIndex condition, NodeIndex thenPart, NodeIndex elsePart)
+{
+    NodeIndex i = Add(ifNode, condition, thenPart);
+    nodes[i].elsePart = elsePart;
+    return i;
+}
+
+NodeIndex Ast::AddWhile(NodeIndex start, NodeIndex condition, NodeIndex body)
+{
+    NodeIndex i = Add(whileNode, condition, body);
+    nodes[i].loopStart = start;
+    return i;
+}
+
+void Ast::Append(NodeList& list, NodeIndex node)
+{
+    if (node == noNode) {
+        return;
+    }
+    if (list.first == noNode) {
+        list.first = node;
+    } else {
+        nodes[list.last].next = node;
+    }
+    list.last = node;
+}
+
+string_view Ast::Text(NodeIndex i) const
+{
+    return string_view(text).substr(nodes[i].text.offset, nodes[i].text.length);
+}
+
+void Ast::Clear()
+{
+    nodes.resize(1);
+    text.clear();
+}
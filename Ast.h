@@ -0,0 +1,116 @@
+/*
+ * Ast.h
+ *
+ * CSC 446 - Compiler Construction - Abstract Syntax Tree Header
+ *
+ * Author: Landon Dahmen
+ *
+ * Description:
+ *   This header file declares the Ast class, which holds the statements of
+ *   one procedure body as the parser recognises them. The parser no longer
+ *   emits three address code as it goes; it builds the body here and lowers
+ *   it in one pass once the whole procedure has been read.
+ *
+ *   Nodes are kept in one array and refer to their children by index, not by
+ *   pointer, so a body is a single contiguous block that is cheap to walk and
+ *   is freed all at once by Clear, which keeps the storage for the next body.
+ *   Index 0 is never a node and stands for "none". Lists of statements,
+ *   arguments and get/put items are chained through next. Text that must
+ *   outlive the token it came from (numbers as written, operators, string
+ *   literals) is copied into one buffer and referred to by offset.
+ *
+ *   A numberNode marked foldable also carries its value, so operators on
+ *   known integers can be worked out while parsing instead of at run time.
+ *
+ *   An if statement is an ifNode whose else part holds its else statements;
+ *   an elsif is an else part of a single ifNode.
+ *
+ *   Children are always added before their parent, so every node of a while
+ *   loop lies between its loopStart and the whileNode itself, and the loop
+ *   optimisations scan that range instead of walking the tree.
+ *
+ *   Identifiers are resolved while parsing, so a node holds the symbol table
+ *   entry it names. Those entries stay valid until the procedure's scope is
+ *   deleted, which happens after its body has been lowered.
+ */
+#ifndef _AST_H
+#define _AST_H
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "SymbolTable.h"
+
+using namespace std;
+
+typedef uint32_t NodeIndex;
+const NodeIndex noNode = 0;
+
+enum NodeKind : uint8_t {
+    assignNode,     // entry := left
+    callNode,       // entry ( left, ... )
+    getNode,        // get ( left, ... ), each a nameNode
+    putNode,        // put ( left, ... ), a putln when flags has putLine
+    nameNode,       // entry, or nullptr for an identifier that was not declared
+    numberNode,     // text as written, and value if foldable
+    stringNode,     // text of a string literal
+    binaryNode,     // left text right, text the operator
+    notNode,        // not left
+    negateNode,     // - left
+    ifNode,         // if left then right (a list) else elsePart (a list)
+    whileNode       // while left loop right (a list) end loop
+};
+
+const uint8_t putLine = 1;
+const uint8_t foldable = 2;         // a numberNode with an integer value
+
+
+struct AstNode {
+    NodeKind kind;
+    uint8_t flags;
+    int16_t value;      // of a foldable numberNode
+    NodeIndex left;     // first operand, or first item of a list
+    NodeIndex right;    // second operand
+    NodeIndex next;     // next statement, argument or item
+    union {
+        const TableEntry* entry;
+        struct {
+            uint32_t offset;
+            uint32_t length;
+        } text;
+        NodeIndex elsePart;     // of an ifNode
+        NodeIndex loopStart;    // of a whileNode, the first node of the loop
+    };
+};
+
+// a list under construction, appended to at its end
+struct NodeList {
+    NodeIndex first = noNode;
+    NodeIndex last = noNode;
+};
+
+class Ast {
+    public:
+        Ast();
+        NodeIndex Add(NodeKind kind, NodeIndex left = noNode, NodeIndex right = noNode,
+                      uint8_t flags = 0);
+        NodeIndex AddEntry(NodeKind kind, const TableEntry* entry, NodeIndex left = noNode);
+        NodeIndex AddText(NodeKind kind, string_view text, NodeIndex left = noNode,
+                          NodeIndex right = noNode);
+        NodeIndex AddNumber(string_view text, int16_t value);  // a foldable number
+        NodeIndex AddIf(NodeIndex condition, NodeIndex thenPart, NodeIndex elsePart);
+        NodeIndex AddWhile(NodeIndex start, NodeIndex condition, NodeIndex body);
+        void Append(NodeList& list, NodeIndex node);   // noNode is not appended
+
+        const AstNode& operator[](NodeIndex i) const { return nodes[i]; }
+        string_view Text(NodeIndex i) const;
+        bool Foldable(NodeIndex i) const { return (nodes[i].flags & foldable) != 0; }
+        size_t Size() const { return nodes.size() - 1; }
+        NodeIndex NextIndex() const { return static_cast<NodeIndex>(nodes.size()); }
+        void Clear();
+
+    private:
+        vector<AstNode> nodes;      // nodes[0] is the unused noNode
+        string text;
+};
+#endif
@@ -0,0 +1,256 @@
+/*
+ * CharScan.cpp
+ *
+ * CSC 446 - Compiler Construction - Bulk Character Scanning Implementation
+ *
+ * Author: Landon Dahmen
+ *
+ * Description:
+ *   This file implements the run scanners declared in CharScan.h. Every
+ *   vector kernel compares a whole block against the characters of its class,
+ *   turns the result into a bit mask with movemask and uses the lowest set bit
+ *   to find where the run ends. The last partial block is finished by the
+ *   scalar code. The AVX2 kernels are compiled with a target attribute so the
+ *   rest of the program does not need -mavx2.
+ */
+#include "CharScan.h"
+
+#if defined(__x86_64__)
+#define CHARSCAN_X86 1
+#include <immintrin.h>
+#endif
+
+// ------------------------------------------------------------------ scalar
+
+static inline bool IsSpaceByte(char c)
+{
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+static inline bool IsIdentByte(char c)
+{
+    char folded = c | 0x20;
+    return (folded >= 'a' && folded <= 'z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+static size_t SkipWhitespaceScalar(const char* s, size_t i, size_t to)
+{
+    while (i < to && IsSpaceByte(s[i])) {
+        i++;
+    }
+    return i;
+}
+
+static size_t FindLineEndScalar(const char* s, size_t i, size_t to)
+{
+    while (i < to && s[i] != '\n') {
+        i++;
+    }
+    return i;
+}
+
+static size_t SkipIdentifierScalar(const char* s, size_t i, size_t to)
+{
+    while (i < to && IsIdentByte(s[i])) {
+        i++;
+    }
+    return i;
+}
+
+static size_t FindLiteralEndScalar(const char* s, size_t i, size_t to)
+{
+    while (i < to && s[i] != '"' && s[i] != '\n') {
+        i++;
+    }
+    return i;
+}
+
+#ifdef CHARSCAN_X86
+// ------------------------------------------------------------------ SSE2
+
+static size_t SkipWhitespaceSSE2(const char* s, size_t i, size_t to)
+{
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i belowTab = _mm_set1_epi8('\t' - 1);
+    const __m128i aboveCr = _mm_set1_epi8('\r' + 1);
+    while (i + 16 <= to) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        __m128i ws = _mm_or_si128(_mm_cmpeq_epi8(v, space),
+            _mm_and_si128(_mm_cmpgt_epi8(v, belowTab), _mm_cmplt_epi8(v, aboveCr)));
+        unsigned stop = ~_mm_movemask_epi8(ws) & 0xFFFFu;
+        if (stop != 0) {
+            return i + __builtin_ctz(stop);
+        }
+        i += 16;
+    }
+    return SkipWhitespaceScalar(s, i, to);
+}
+
+static size_t FindLineEndSSE2(const char* s, size_t i, size_t to)
+{
+    const __m128i newline = _mm_set1_epi8('\n');
+    while (i + 16 <= to) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        unsigned hit = _mm_movemask_epi8(_mm_cmpeq_epi8(v, newline));
+        if (hit != 0) {
+            return i + __builtin_ctz(hit);
+        }
+        i += 16;
+    }
+    return FindLineEndScalar(s, i, to);
+}
+
+static size_t SkipIdentifierSSE2(const char* s, size_t i, size_t to)
+{
+    const __m128i caseBit = _mm_set1_epi8(0x20);
+    const __m128i belowA = _mm_set1_epi8('a' - 1);
+    const __m128i aboveZ = _mm_set1_epi8('z' + 1);
+    const __m128i below0 = _mm_set1_epi8('0' - 1);
+    const __m128i above9 = _mm_set1_epi8('9' + 1);
+    const __m128i underscore = _mm_set1_epi8('_');
+    while (i + 16 <= to) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        __m128i folded = _mm_or_si128(v, caseBit);
+        __m128i letter = _mm_and_si128(_mm_cmpgt_epi8(folded, belowA), _mm_cmplt_epi8(folded, aboveZ));
+        __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(v, below0), _mm_cmplt_epi8(v, above9));
+        __m128i ident = _mm_or_si128(_mm_or_si128(letter, digit), _mm_cmpeq_epi8(v, underscore));
+        unsigned stop = ~_mm_movemask_epi8(ident) & 0xFFFFu;
+        if (stop != 0) {
+            return i + __builtin_ctz(stop);
+        }
+        i += 16;
+    }
+    return SkipIdentifierScalar(s, i, to);
+}
+
+static size_t FindLiteralEndSSE2(const char* s, size_t i, size_t to)
+{
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i newline = _mm_set1_epi8('\n');
+    while (i + 16 <= to) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        unsigned hit = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, newline)));
+        if (hit != 0) {
+            return i + __builtin_ctz(hit);
+        }
+        i += 16;
+    }
+    return FindLiteralEndScalar(s, i, to);
+}
+
+// ------------------------------------------------------------------ AVX2
+
+#define AVX2_TARGET __attribute__((target("avx2,bmi")))
+
+AVX2_TARGET
+static size_t SkipWhitespaceAVX2(const char* s, size_t i, size_t to)
+{
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i belowTab = _mm256_set1_epi8('\t' - 1);
+    const __m256i aboveCr = _mm256_set1_epi8('\r' + 1);
+    while (i + 32 <= to) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i));
+        __m256i ws = _mm256_or_si256(_mm256_cmpeq_epi8(v, space),
+            _mm256_and_si256(_mm256_cmpgt_epi8(v, belowTab), _mm256_cmpgt_epi8(aboveCr, v)));
+        unsigned stop = ~static_cast<unsigned>(_mm256_movemask_epi8(ws));
+        if (stop != 0) {
+            return i + __builtin_ctz(stop);
+        }
+        i += 32;
+    }
+    return SkipWhitespaceSSE2(s, i, to);
+}
+
+AVX2_TARGET
+static size_t FindLineEndAVX2(const char* s, size_t i, size_t to)
+{
+    const __m256i newline = _mm256_set1_epi8('\n');
+    while (i + 32 <= to) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i));
+        unsigned hit = _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, newline));
+        if (hit != 0) {
+            return i + __builtin_ctz(hit);
+        }
+        i += 32;
+    }
+    return FindLineEndSSE2(s, i, to);
+}
+
+AVX2_TARGET
+static size_t SkipIdentifierAVX2(const char* s, size_t i, size_t to)
+{
+    const __m256i caseBit = _mm256_set1_epi8(0x20);
+    const __m256i belowA = _mm256_set1_epi8('a' - 1);
+    const __m256i aboveZ = _mm256_set1_epi8('z' + 1);
+    const __m256i below0 = _mm256_set1_epi8('0' - 1);
+    const __m256i above9 = _mm256_set1_epi8('9' + 1);
+    const __m256i underscore = _mm256_set1_epi8('_');
+    while (i + 32 <= to) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i));
+        __m256i folded = _mm256_or_si256(v, caseBit);
+        __m256i letter = _mm256_and_si256(_mm256_cmpgt_epi8(folded, belowA), _mm256_cmpgt_epi8(aboveZ, folded));
+        __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(v, below0), _mm256_cmpgt_epi8(above9, v));
+        __m256i ident = _mm256_or_si256(_mm256_or_si256(letter, digit), _mm256_cmpeq_epi8(v, underscore));
+        unsigned stop = ~static_cast<unsigned>(_mm256_movemask_epi8(ident));
+        if (stop != 0) {
+            return i + __builtin_ctz(stop);
+        }
+        i += 32;
+    }
+    return SkipIdentifierSSE2(s, i, to);
+}
+
+AVX2_TARGET
+static size_t FindLiteralEndAVX2(const char* s, size_t i, size_t to)
+{
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i newline = _mm256_set1_epi8('\n');
+    while (i + 32 <= to) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i));
+        unsigned hit = _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, newline)));
+        if (hit != 0) {
+            return i + __builtin_ctz(hit);
+        }
+        i += 32;
+    }
+    return FindLiteralEndSSE2(s, i, to);
+}
+#endif // CHARSCAN_X86
+
+// ------------------------------------------------------------------ dispatch
+
+static constexpr ScanKernels scalarKernels = {
+    SkipWhitespaceScalar, FindLineEndScalar, SkipIdentifierScalar, FindLiteralEndScalar
+};
+
+#ifdef CHARSCAN_X86
+static constexpr ScanKernels sse2Kernels = {
+    SkipWhitespaceSSE2, FindLineEndSSE2, SkipIdentifierSSE2, FindLiteralEndSSE2
+};
+
+static constexpr ScanKernels avx2Kernels = {
+    SkipWhitespaceAVX2, FindLineEndAVX2, SkipIdentifierAVX2, FindLiteralEndAVX2
+};
+#endif
+
+ScanLevel SelectScanKernels(ScanLevel max)
+{
+#ifdef CHARSCAN_X86
+    __builtin_cpu_init();
+    if (max >= scanAVX2 && __builtin_cpu_supports("avx2")) {
+        scanKernels = avx2Kernels;
+        return scanAVX2;
+    }
+    if (max >= scanSSE2 && __builtin_cpu_supports("sse2")) {
+        scanKernels = sse2Kernels;
+        return scanSSE2;
+    }
+#endif
+    scanKernels = scalarKernels;
+    return scanScalar;
+}
+
+ScanKernels scanKernels = scalarKernels;
+
+// pick the kernels before main runs
+[[maybe_unused]] static const ScanLevel startupScanLevel = SelectScanKernels();
@@ -0,0 +1,58 @@
+/*
+ * CharScan.h
+ *
+ * CSC 446 - Compiler Construction - Bulk Character Scanning Header
+ *
+ * Author: Landon Dahmen
+ *
+ * Description:
+ *   This header file declares the run scanners the lexical analyzer uses to
+ *   step over whitespace, comment bodies, identifier characters and string
+ *   literal bodies many bytes at a time. Each scanner is passed a buffer and
+ *   a range [from, to) and returns the index of the first byte that ends the
+ *   run (or to). SSE2 and AVX2 versions are picked once at startup from the
+ *   CPU's feature flags; other machines use the scalar versions.
+ */
+#ifndef _CHARSCAN_H
+#define _CHARSCAN_H
+#include <cstddef>
+
+enum ScanLevel { scanScalar, scanSSE2, scanAVX2 };
+
+struct ScanKernels {
+    // whitespace run
+    size_t (*skipWhitespace)(const char* s, size_t from, size_t to);
+    // first '\n' (end of a -- comment)
+    size_t (*findLineEnd)(const char* s, size_t from, size_t to);
+    // letters, digits and '_'
+    size_t (*skipIdentifier)(const char* s, size_t from, size_t to);
+    // first '"' or '\n' (end of a string literal body)
+    size_t (*findLiteralEnd)(const char* s, size_t from, size_t to);
+};
+
+extern ScanKernels scanKernels;
+
+// Selects the best kernels the CPU supports, but no better than max.
+// Returns the level actually selected.
+ScanLevel SelectScanKernels(ScanLevel max = scanAVX2);
+
+inline size_t SkipWhitespace(const char* s, size_t from, size_t to)
+{
+    return scanKernels.skipWhitespace(s, from, to);
+}
+
+inline size_t FindLineEnd(const char* s, size_t from, size_t to)
+{
+    return scanKernels.findLineEnd(s, from, to);
+}
+
+inline size_t SkipIdentifier(const char* s, size_t from, size_t to)
+{
+    return scanKernels.skipIdentifier(s, from, to);
+}
+
+inline size_t FindLiteralEnd(const char* s, size_t from, size_t to)
+{
+    return scanKernels.findLiteralEnd(s, from, to);
+}
+#endif
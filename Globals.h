@@ -1,14 +1,13 @@
-// contains globals used
+// contains globals used; each thread has its own copy so that several
+// lexers (or parsers) can run at once
 #ifndef GLOBALS_H
 #define GLOBALS_H
 
-extern ifstream inputfile;
-extern Symbol Token;
-extern string Lexeme;
-extern char ch;
-extern int LineNo;
-extern int Value;
-extern double ValueR;
-extern string Literal;
+extern thread_local Symbol Token;
+extern thread_local string_view Lexeme;
+extern thread_local char ch;
+extern thread_local int Value;
+extern thread_local double ValueR;
+extern thread_local string Literal;
 
 #endif // GLOBALS_H
\ No newline at end of file
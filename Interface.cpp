@@ -0,0 +1,112 @@
+/*
+ * Interface.cpp
+ *
+ * CSC 446 - Compiler Construction - Procedure Interface Files Implementation
+ *
+ * Author: Landon Dahmen
+ *
+ * Description:
+ *   This file implements the interface file reader and writer declared in
+ *   Interface.h. The reader maps the file with a SourceBuffer and checks
+ *   every count and offset against the file size before trusting it.
+ */
+#include <fstream>
+#include <cstring>
+#include "Interface.h"
+#include "SourceBuffer.h"
+
+using namespace std;
+
+bool WriteInterface(const string& path, const vector<TableEntry*>& procedures)
+{
+    vector<InterfaceProcedure> records;
+    vector<InterfaceParameter> parameters;
+    string names;
+    for (const TableEntry* entry : procedures) {
+        InterfaceProcedure record;
+        record.nameOffset = names.size();
+        record.nameLength = entry->lexeme.size();
+        record.sizeOfLocal = entry->function.SizeOfLocal;
+        record.firstParameter = parameters.size();
+        record.parameterCount = 0;
+        for (const ParamNode* node = entry->function.ParamList; node != nullptr; node = node->next) {
+            InterfaceParameter parameter = {};
+            parameter.type = node->typeOfParameter;
+            parameter.mode = node->mode;
+            parameters.push_back(parameter);
+            record.parameterCount++;
+        }
+        records.push_back(record);
+        names += entry->lexeme;
+    }
+    names.resize((names.size() + 3) & ~size_t(3), '\0');
+
+    InterfaceHeader header;
+    memcpy(header.magic, interfaceMagic, sizeof(header.magic));
+    header.procedureCount = records.size();
+    header.parameterCount = parameters.size();
+    header.nameBytes = names.size();
+
+    ofstream out(path, ios::binary);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(records[0]));
+    out.write(reinterpret_cast<const char*>(parameters.data()), parameters.size() * sizeof(parameters[0]));
+    out.write(names.data(), names.size());
+    return static_cast<bool>(out);
+}
+
+bool LoadInterface(const string& path, SymbolTable& st, int depth,
+                   vector<TableEntry*>& loaded, string& problem)
+{
+    SourceBuffer file;
+    if (!file.Open(path)) {
+        problem = "could not open file";
+        return false;
+    }
+    const char* data = file.Data();
+    size_t size = file.Size();
+    const InterfaceHeader* header = reinterpret_cast<const InterfaceHeader*>(data);
+    if (size < sizeof(InterfaceHeader) || memcmp(header->magic, interfaceMagic, sizeof(header->magic)) != 0) {
+        problem = "not an interface file";
+        return false;
+    }
+    size_t procedureBytes = size_t(header->procedureCount) * sizeof(InterfaceProcedure);
+    size_t parameterBytes = size_t(header->parameterCount) * sizeof(InterfaceParameter);
+    if (sizeof(InterfaceHeader) + procedureBytes + parameterBytes + header->nameBytes != size) {
+        problem = "file is truncated or corrupt";
+        return false;
+    }
+    const InterfaceProcedure* records =
+        reinterpret_cast<const InterfaceProcedure*>(data + sizeof(InterfaceHeader));
+    const InterfaceParameter* parameters =
+        reinterpret_cast<const InterfaceParameter*>(data + sizeof(InterfaceHeader) + procedureBytes);
+    const char* names = data + sizeof(InterfaceHeader) + procedureBytes + parameterBytes;
+
+    for (uint32_t i = 0; i < header->procedureCount; i++) {
+        const InterfaceProcedure& record = records[i];
+        if (size_t(record.nameOffset) + record.nameLength > header->nameBytes || record.nameLength == 0 ||
+            size_t(record.firstParameter) + record.parameterCount > header->parameterCount) {
+            problem = "file is truncated or corrupt";
+            return false;
+        }
+        string_view name(names + record.nameOffset, record.nameLength);
+        if (st.Lookup(name) != nullptr) {
+            problem = "duplicate identifier: " + string(name);
+            return false;
+        }
+        TableEntry* entry = st.Insert(name, idt, depth, functionEntry);
+        entry->function.SizeOfLocal = record.sizeOfLocal;
+        entry->function.NumberOfParameters = 0;
+        entry->function.ParamList = nullptr;
+        for (uint32_t p = 0; p < record.parameterCount; p++) {
+            const InterfaceParameter& parameter = parameters[record.firstParameter + p];
+            if (parameter.type > floatType || parameter.mode > modeInOut) {
+                problem = "file is truncated or corrupt";
+                return false;
+            }
+            st.AddParam(entry, VarType(parameter.type), ParamMode(parameter.mode));
+        }
+        loaded.push_back(entry);
+    }
+    return true;
+}
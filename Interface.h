@@ -0,0 +1,65 @@
+/*
+ * Interface.h
+ *
+ * CSC 446 - Compiler Construction - Procedure Interface Files Header
+ *
+ * Author: Landon Dahmen
+ *
+ * Description:
+ *   This header file declares the reader and writer for interface files
+ *   (.adi), which let a program call the procedures of a library compiled
+ *   on its own. Compiling the library with --emit-interface writes the
+ *   procedures declared directly inside its outer procedure: for each one
+ *   its name, local size and the type and mode of every parameter. A
+ *   program compiled with --interface lib.adi starts with those procedures
+ *   in its symbol table at depth 0, so calls to them are checked (the
+ *   number of arguments, their types, and a variable for every out or in out
+ *   parameter) and emitted without parsing the library source again. Only
+ *   the program includes io.asm: a library declares its routines EXTRN and
+ *   the program makes them PUBLIC, so the two modules link.
+ *
+ *   The file is a header, then the procedure records, then the parameter
+ *   records, then the names, all fixed width and 4 byte aligned, so it is
+ *   mapped and read in place. Integers are stored in the byte order of the
+ *   machine that wrote the file.
+ */
+#ifndef _INTERFACE_H
+#define _INTERFACE_H
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "SymbolTable.h"
+
+using namespace std;
+
+const char interfaceMagic[4] = {'A', 'D', 'I', '1'};
+
+struct InterfaceHeader {
+    char magic[4];
+    uint32_t procedureCount;
+    uint32_t parameterCount;
+    uint32_t nameBytes;
+};
+
+struct InterfaceProcedure {
+    uint32_t nameOffset;        // into the names that follow the parameters
+    uint32_t nameLength;
+    int32_t sizeOfLocal;
+    uint32_t firstParameter;    // index of its first parameter record
+    uint32_t parameterCount;
+};
+
+struct InterfaceParameter {
+    uint8_t type;               // VarType
+    uint8_t mode;               // ParamMode
+    uint8_t unused[2];
+};
+
+// write the given procedure entries; false if the file cannot be written
+bool WriteInterface(const string& path, const vector<TableEntry*>& procedures);
+
+// insert the procedures of an interface file into st at depth as function
+// entries, appending them to loaded; on failure problem says why
+bool LoadInterface(const string& path, SymbolTable& st, int depth,
+                   vector<TableEntry*>& loaded, string& problem);
+#endif
@@ -0,0 +1,144 @@
+/*
+ * InternTable.cpp
+ *
+ * CSC 446 - Compiler Construction - Identifier Intern Table Implementation
+ *
+ * Author: Landon Dahmen
+ *
+ * Description:
+ *   This file implements the InternTable class declared in InternTable.h.
+ *   Names are found by linear probing on a word-at-a-time hash; nothing is
+ *   ever removed, so there are no tombstones, and a probe that reaches an
+ *   empty slot has seen every name stored before it.
+ */
+#include <cstring>
+#include "InternTable.h"
+
+using namespace std;
+
+InternTable::InternTable() : count(1)
+{
+    pages[0].reset(new string_view[firstPage]);
+    tables.emplace_back(new Slots(1024));
+    current.store(tables.back().get(), memory_order_release);
+}
+
+Atom InternTable::Intern(string_view name)
+{
+    uint32_t h = Hash(name);
+    size_t i;
+    uint64_t found = FindSlot(*current.load(memory_order_acquire), name, h, i);
+    if (found != 0) {
+        return static_cast<Atom>(found);
+    }
+    lock_guard<mutex> hold(lock);
+    // probe again: another thread may have added the name, or grown the table
+    Slots* table = current.load(memory_order_relaxed);
+    found = FindSlot(*table, name, h, i);
+    if (found != 0) {
+        return static_cast<Atom>(found);
+    }
+    size_t atom = count.load(memory_order_relaxed);
+    if (atom * 4 > (table->mask + 1) * 3) {
+        Grow();
+        table = current.load(memory_order_relaxed);
+        FindSlot(*table, name, h, i);
+    }
+    int page = Page(atom);
+    if (!pages[page]) {
+        pages[page].reset(new string_view[firstPage << page]);
+    }
+    Entry(atom) = text.Copy(name);
+    // the name is written before the slot or the count can show it
+    table->slot[i].store(uint64_t(h) << 32 | atom, memory_order_release);
+    count.store(atom + 1, memory_order_release);
+    return static_cast<Atom>(atom);
+}
+
+Atom InternTable::Find(string_view name) const
+{
+    size_t i;
+    return static_cast<Atom>(FindSlot(*current.load(memory_order_acquire), name, Hash(name), i));
+}
+
+string_view InternTable::Name(Atom atom) const
+{
+    return Entry(atom);
+}
+
+size_t InternTable::Count() const
+{
+    return count.load(memory_order_acquire) - 1;
+}
+
+int InternTable::Page(size_t atom)
+{
+    size_t index = atom + firstPage;
+    int page = 0;
+    while (index >> (page + 1) >= firstPage) {
+        page++;
+    }
+    return page;
+}
+
+string_view& InternTable::Entry(size_t atom) const
+{
+    int page = Page(atom);
+    return pages[page][atom + firstPage - (firstPage << page)];
+}
+
+// the atom of name, 0 if it is not in table; i is its slot or the empty
+// slot that ended the probe
+uint64_t InternTable::FindSlot(const Slots& table, string_view name, uint32_t h, size_t& i) const
+{
+    for (i = h & table.mask;; i = (i + 1) & table.mask) {
+        uint64_t slot = table.slot[i].load(memory_order_acquire);
+        if (slot == 0) {
+            return 0;
+        }
+        if (slot >> 32 == h && Entry(slot & 0xffffffff) == name) {
+            return slot & 0xffffffff;
+        }
+    }
+}
+
+void InternTable::Grow()
+{
+    // rehash from the stored hashes into a new table, then publish it; a
+    // reader still probing the old one finds every name it held
+    const Slots& old = *current.load(memory_order_relaxed);
+    tables.emplace_back(new Slots((old.mask + 1) * 2));
+    Slots& grown = *tables.back();
+    for (size_t j = 0; j <= old.mask; j++) {
+        uint64_t slot = old.slot[j].load(memory_order_relaxed);
+        if (slot != 0) {
+            size_t i = (slot >> 32) & grown.mask;
+            while (grown.slot[i].load(memory_order_relaxed) != 0) {
+                i = (i + 1) & grown.mask;
+            }
+            grown.slot[i].store(slot, memory_order_relaxed);
+        }
+    }
+    current.store(&grown, memory_order_release);
+}
+
+uint32_t InternTable::Hash(string_view name)
+{
+    // eight bytes at a time, then mixed so every byte reaches the low bits
+    // used to pick a slot
+    const uint64_t k = 0x9e3779b97f4a7c15;
+    uint64_t h = name.size() * k;
+    size_t i = 0;
+    uint64_t word;
+    for (; i + 8 <= name.size(); i += 8) {
+        memcpy(&word, name.data() + i, 8);
+        h = (h ^ word) * k;
+    }
+    word = 0;
+    memcpy(&word, name.data() + i, name.size() - i);
+    h = (h ^ word) * k;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccd;
+    h ^= h >> 33;
+    return static_cast<uint32_t>(h);
+}
@@ -0,0 +1,80 @@
+/*
+ * InternTable.h
+ *
+ * CSC 446 - Compiler Construction - Identifier Intern Table Header
+ *
+ * Author: Landon Dahmen
+ *
+ * Description:
+ *   This header file declares the InternTable class, which gives every
+ *   distinct identifier a small integer, its atom. The lexer interns each
+ *   identifier as it reads it and the atom travels with the token, so the
+ *   symbol table and the parser compare and hash atoms instead of strings.
+ *   The text of each name is stored once, in an arena, and Name(atom) views
+ *   it for as long as the table lives.
+ *
+ *   Several lexers may intern at once (parallel chunks, the pipeline
+ *   thread), but only adding a name takes the mutex. Names are stored in
+ *   pages that never move and the count is published after the name is
+ *   written, so Name and Count read without locking; a slot is one atomic
+ *   word written after its name, and a table outgrown by Grow is kept until
+ *   the InternTable goes, so Find (and Intern of a name already there)
+ *   probes without locking too. Atom 0 is never given out; it stands for
+ *   "no identifier".
+ */
+#ifndef _INTERNTABLE_H
+#define _INTERNTABLE_H
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+#include "Arena.h"
+
+using namespace std;
+
+typedef uint32_t Atom;
+const Atom noAtom = 0;
+
+class InternTable {
+    public:
+        InternTable();
+
+        Atom Intern(string_view name);          // the atom of name, new if need be
+        Atom Find(string_view name) const;      // noAtom if name was never interned
+        string_view Name(Atom atom) const;
+        size_t Count() const;                   // atoms given out
+
+        static uint32_t Hash(string_view name);
+
+    private:
+        InternTable(const InternTable&) = delete;
+        InternTable& operator=(const InternTable&) = delete;
+
+        // a slot is its atom in the low half and the name's hash in the high
+        // half; 0 is an empty slot
+        struct Slots {
+            explicit Slots(size_t size) : mask(size - 1), slot(new atomic<uint64_t>[size]()) {}
+            size_t mask;                        // size - 1, a power of two
+            unique_ptr<atomic<uint64_t>[]> slot;
+        };
+
+        uint64_t FindSlot(const Slots& table, string_view name, uint32_t h, size_t& i) const;
+        void Grow();
+
+        // page p holds the firstPage << p atoms after those of the pages
+        // before it, so a page is never copied to make room
+        static const size_t firstPage = 1024;
+        static const int pageCount = 23;        // enough for every 32 bit atom
+        static int Page(size_t atom);
+        string_view& Entry(size_t atom) const;
+
+        mutable mutex lock;         // held only to add a name
+        Arena text;                 // the characters of every name
+        unique_ptr<string_view[]> pages[pageCount];     // names, indexed by atom
+        atomic<size_t> count;       // atoms given out, noAtom included
+        atomic<Slots*> current;     // open addressing, probed without the lock
+        vector<unique_ptr<Slots>> tables;   // current and every table it replaced
+};
+#endif
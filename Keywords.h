@@ -0,0 +1,122 @@
+/*
+ * Keywords.h
+ *
+ * CSC 446 - Compiler Construction - Reserved Word Table
+ *
+ * Author: Landon Dahmen
+ *
+ * Description:
+ *   This header file holds the reserved words of the Ada subset and a perfect
+ *   hash over them that is built entirely at compile time. The hash folds
+ *   upper case to lower case as it goes, so a word read from the source can be
+ *   classified in place: one hash, one table probe and at most one comparison
+ *   against the single candidate keyword, with no copies or heap allocation.
+ */
+#ifndef _KEYWORDS_H
+#define _KEYWORDS_H
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+#include "LexicalAnalyzer.h"
+
+using namespace std;
+
+struct Keyword {
+    string_view spelling;   // lower case text as written in the source
+    string_view lexeme;     // what Lexeme is set to when it is recognized
+    Symbol token;
+};
+
+constexpr Keyword keywordList[] = {
+    {"begin", "begin", begint}, {"module", "module", modulet},
+    {"constant", "constant", constantt}, {"procedure", "procedure", proceduret},
+    {"is", "is", ist}, {"if", "if", ift}, {"then", "then", thent},
+    {"else", "else", elset}, {"elsif", "elsif", elsift}, {"while", "while", whilet},
+    {"loop", "loop", loopt}, {"float", "float", floatt}, {"integer", "integer", integert},
+    {"char", "char", chart}, {"get", "get", gett}, {"put", "put", putt},
+    {"putln", "putln", putlnt}, {"end", "end", endt},
+    {"or", "or", addopt}, {"and", "and", mulopt}, {"rem", "rem", mulopt},
+    {"mod", "mod", mulopt}, {"in", "in", in}, {"out", "out", out},
+    {"inout", "inout", inout}, {"not", "not", nott},
+    {"real", "float", floatt}       // real is accepted as a synonym for float
+};
+
+constexpr int keywordCount = sizeof(keywordList) / sizeof(keywordList[0]);
+constexpr int keywordSlotBits = 7;
+constexpr int keywordSlots = 1 << keywordSlotBits;
+constexpr size_t keywordMinLength = 2;
+constexpr size_t keywordMaxLength = 9;
+
+// letters only: setting bit 5 maps 'A'..'Z' onto 'a'..'z'
+constexpr unsigned char FoldCase(char c)
+{
+    return static_cast<unsigned char>(c) | 0x20;
+}
+
+// FNV-1a over the case-folded characters, seeded so the keywords never collide
+constexpr uint32_t KeywordHash(const char* s, size_t length, uint32_t seed)
+{
+    uint32_t h = seed ^ static_cast<uint32_t>(length);
+    for (size_t i = 0; i < length; i++) {
+        h = (h ^ FoldCase(s[i])) * 16777619u;
+    }
+    return h >> (32 - keywordSlotBits);
+}
+
+constexpr uint32_t FindKeywordSeed()
+{
+    for (uint32_t seed = 2166136261u; ; seed++) {
+        bool used[keywordSlots] = {};
+        bool collision = false;
+        for (int i = 0; i < keywordCount && !collision; i++) {
+            const Keyword& k = keywordList[i];
+            uint32_t slot = KeywordHash(k.spelling.data(), k.spelling.size(), seed);
+            collision = used[slot];
+            used[slot] = true;
+        }
+        if (!collision) {
+            return seed;
+        }
+    }
+}
+
+constexpr uint32_t keywordSeed = FindKeywordSeed();
+
+struct KeywordSlotTable {
+    signed char index[keywordSlots] = {};
+};
+
+constexpr KeywordSlotTable BuildKeywordSlots()
+{
+    KeywordSlotTable table;
+    for (int i = 0; i < keywordSlots; i++) {
+        table.index[i] = -1;
+    }
+    for (int i = 0; i < keywordCount; i++) {
+        const Keyword& k = keywordList[i];
+        table.index[KeywordHash(k.spelling.data(), k.spelling.size(), keywordSeed)] = i;
+    }
+    return table;
+}
+
+constexpr KeywordSlotTable keywordSlotTable = BuildKeywordSlots();
+
+// Returns the reserved word spelled by s (in any case), or nullptr for an identifier.
+inline const Keyword* FindKeyword(const char* s, size_t length)
+{
+    if (length < keywordMinLength || length > keywordMaxLength) {
+        return nullptr;
+    }
+    int i = keywordSlotTable.index[KeywordHash(s, length, keywordSeed)];
+    if (i < 0 || keywordList[i].spelling.size() != length) {
+        return nullptr;
+    }
+    const char* k = keywordList[i].spelling.data();
+    for (size_t j = 0; j < length; j++) {
+        if (FoldCase(s[j]) != static_cast<unsigned char>(k[j])) {
+            return nullptr;
+        }
+    }
+    return &keywordList[i];
+}
+#endif
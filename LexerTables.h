@@ -0,0 +1,119 @@
+/*
+ * LexerTables.h
+ *
+ * CSC 446 - Compiler Construction - Lexer Character Class and Transition Tables
+ *
+ * Author: Landon Dahmen
+ *
+ * Description:
+ *   This header file builds, at compile time, the two tables that drive the
+ *   lexical analyzer. charClasses maps every byte to a character class, which
+ *   replaces the ctype calls (and their dependence on the locale). lexTransitions
+ *   is the DFA for the operator and punctuation tokens: from each state and
+ *   character class it gives the next state, or the token to accept and
+ *   whether the current character belongs to it. Letters, digits and quotes
+ *   start the longer scans in ProcessWordToken, ProcessNumToken and
+ *   ProcessLiteralToken instead.
+ */
+#ifndef _LEXERTABLES_H
+#define _LEXERTABLES_H
+#include "LexicalAnalyzer.h"
+
+enum CharClass : unsigned char {
+    ccOther, ccSpace, ccLetter, ccDigit, ccQuote, ccColon, ccLess, ccGreater,
+    ccSlash, ccEqual, ccPlus, ccMinus, ccStar, ccLParen, ccRParen, ccComma,
+    ccSemi, ccPeriod, charClassCount
+};
+
+struct CharClassTable {
+    CharClass of[256] = {};
+};
+
+constexpr CharClassTable BuildCharClasses()
+{
+    CharClassTable table;
+    for (int c = 'a'; c <= 'z'; c++) {
+        table.of[c] = ccLetter;
+        table.of[c - 'a' + 'A'] = ccLetter;
+    }
+    for (int c = '0'; c <= '9'; c++) {
+        table.of[c] = ccDigit;
+    }
+    for (int c = '\t'; c <= '\r'; c++) {
+        table.of[c] = ccSpace;
+    }
+    table.of[int(' ')] = ccSpace;
+    table.of[int('"')] = ccQuote;
+    table.of[int(':')] = ccColon;
+    table.of[int('<')] = ccLess;
+    table.of[int('>')] = ccGreater;
+    table.of[int('/')] = ccSlash;
+    table.of[int('=')] = ccEqual;
+    table.of[int('+')] = ccPlus;
+    table.of[int('-')] = ccMinus;
+    table.of[int('*')] = ccStar;
+    table.of[int('(')] = ccLParen;
+    table.of[int(')')] = ccRParen;
+    table.of[int(',')] = ccComma;
+    table.of[int(';')] = ccSemi;
+    table.of[int('.')] = ccPeriod;
+    return table;
+}
+
+constexpr CharClassTable charClasses = BuildCharClasses();
+
+constexpr CharClass ClassOf(char c)
+{
+    return charClasses.of[static_cast<unsigned char>(c)];
+}
+
+// states of the operator DFA; lsAccept is not a real row of the table
+enum LexState : unsigned char {
+    lsStart, lsColon, lsLess, lsGreater, lsSlash, lexStateCount,
+    lsAccept = lexStateCount
+};
+
+struct LexMove {
+    LexState next = lsAccept;
+    Symbol token = unknownt;    // token accepted when next == lsAccept
+    bool consume = false;       // true if the current character is part of the token
+};
+
+struct LexTransitionTable {
+    LexMove move[lexStateCount][charClassCount] = {};
+};
+
+constexpr LexTransitionTable BuildTransitions()
+{
+    LexTransitionTable table;
+    for (int c = 0; c < charClassCount; c++) {
+        // anything not listed below is an unknown symbol on its own
+        table.move[lsStart][c] = {lsAccept, unknownt, true};
+        // after : < > / anything but '=' ends a one character token
+        table.move[lsColon][c] = {lsAccept, colont, false};
+        table.move[lsLess][c] = {lsAccept, relopt, false};
+        table.move[lsGreater][c] = {lsAccept, relopt, false};
+        table.move[lsSlash][c] = {lsAccept, mulopt, false};
+    }
+    table.move[lsStart][ccPlus] = {lsAccept, addopt, true};
+    table.move[lsStart][ccMinus] = {lsAccept, addopt, true};
+    table.move[lsStart][ccStar] = {lsAccept, mulopt, true};
+    table.move[lsStart][ccEqual] = {lsAccept, relopt, true};
+    table.move[lsStart][ccLParen] = {lsAccept, lparent, true};
+    table.move[lsStart][ccRParen] = {lsAccept, rparent, true};
+    table.move[lsStart][ccComma] = {lsAccept, commat, true};
+    table.move[lsStart][ccSemi] = {lsAccept, semit, true};
+    table.move[lsStart][ccPeriod] = {lsAccept, periodt, true};
+    table.move[lsStart][ccColon] = {lsColon, unknownt, true};
+    table.move[lsStart][ccLess] = {lsLess, unknownt, true};
+    table.move[lsStart][ccGreater] = {lsGreater, unknownt, true};
+    table.move[lsStart][ccSlash] = {lsSlash, unknownt, true};
+    table.move[lsColon][ccEqual] = {lsAccept, assignopt, true};     // :=
+    table.move[lsLess][ccEqual] = {lsAccept, relopt, true};         // <=
+    table.move[lsGreater][ccEqual] = {lsAccept, relopt, true};      // >=
+    table.move[lsSlash][ccEqual] = {lsAccept, relopt, true};        // /=
+    return table;
+}
+
+constexpr LexTransitionTable lexTransitions = BuildTransitions();
+#endif
@@ -9,10 +9,11 @@
  *
  * Description:
  *   This file implements the LexicalAnalyzer class declared in LexicalAnalyzer.h.
- *   It reads the source code from a file, tokenizes the input into identifiers,
+ *   It maps the source file into memory, tokenizes the input into identifiers,
  *   numbers, string literals, and symbols, and handles skipping whitespace and
  *   comments. The implementation includes error handling for unrecognized tokens
- *   and unterminated string literals.
+ *   and unterminated string literals. Lexemes are views into the mapped file;
+ *   only string literals are copied out (into Literal).
  */
 #include <iostream>
 #include <fstream>
@@ -20,132 +21,338 @@
 #include <unordered_map>
 #include <algorithm>        
 #include <string>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <unistd.h>
 #include "LexicalAnalyzer.h"
+#include "Keywords.h"
+#include "CharScan.h"
+#include "LexerTables.h"
+#include "TokenStream.h"
+#include "InternTable.h"
 #include "Globals.h"
 
 using namespace std;
 
-LexicalAnalyzer::LexicalAnalyzer(string name)
+// a chunk smaller than this is not worth starting a thread for
+static const size_t minChunkSize = 256 * 1024;
+
+// tokenStart between tokens, and pinned when no token is held
+static const size_t noToken = SIZE_MAX;
+
+LexicalAnalyzer::LexicalAnalyzer(string name) : diag(&cout)
 {
     Token = unknownt;
     ch = ' ';
 
-    inputfile.open(name);
-    if (!inputfile) {
-        cout << "\033[31mError: could not open file \033[0m" << name << endl;
+    if (name == "-") {
+        source.OpenStream(STDIN_FILENO);
+    } else if (!source.Open(name)) {
+        *diag << "\033[31mError: could not open file \033[0m" << name << endl;
         Token = eoft;
+        opened = false;
     }
+    lines.SetSource(source.Data(), source.Size());
+}
 
-    reservedWords = {
-        {"begin", begint}, {"module", modulet}, {"constant", constantt}, 
-        {"procedure", proceduret}, {"is", ist}, {"if", ift}, {"then", thent}, 
-        {"else", elset}, {"elsif", elsift}, {"while", whilet}, 
-        {"loop", loopt}, {"float", floatt}, {"integer", integert}, 
-        {"char", chart}, {"get", gett}, {"put", putt}, {"putln", putlnt}, {"end", endt},
-        {"+", addopt}, {"-", addopt}, {"and", addopt}, {"or", addopt}, 
-        {"*", mulopt}, {"/", addopt}, {"rem", mulopt}, {"mod", mulopt}, {"and", mulopt},
-        {"in", in}, {"out", out}, {"inout", inout}, {"not", nott}
-    };
+LexicalAnalyzer::LexicalAnalyzer(const char* text, size_t length) : diag(&cout)
+{
+    Token = unknownt;
+    ch = ' ';
+    source.Borrow(text, length);
+    lines.SetSource(text, length);
+}
+
+LexicalAnalyzer::LexicalAnalyzer(int fd, size_t bufferSize) : diag(&cout)
+{
+    Token = unknownt;
+    ch = ' ';
+    source.OpenStream(fd, bufferSize);
 }
 
 LexicalAnalyzer::~LexicalAnalyzer()
 {
-    if(inputfile.is_open()) {
-        inputfile.close();
-    }
 }
 
 void LexicalAnalyzer::GetNextToken()
 {
-    while (isspace(ch)) {
-        // 'eat' whitespace
-        GetNextCh();
+    // 'eat' whitespace and comments a block at a time
+    tokenStart = noToken;
+    for (;;) {
+        if (ClassOf(ch) == ccSpace) {
+            ScanRun(SkipWhitespace, pos);
+        } else if (ch == '-' && PeekCh() == '-') {
+            ProcessComment();
+        } else {
+            break;
+        }
     }
 
-    if (!inputfile.eof()) {
+    if (!atEnd) {
         ProcessToken();
     } else {
-        inputfile.close();
         Token = eoft;
+        tokenStart = Cursor();
         Lexeme = "";
     }
 }
 
-void LexicalAnalyzer::GetNextCh()
+void LexicalAnalyzer::ReadToken(TokenStream& tokens)
+{
+    // the tokens already in the stream may still be read through Lexeme(i)
+    pinned = tokens.Size() > 0 ? tokens.Offset(0) : noToken;
+    GetNextToken();
+    TokenValue value;
+    value.ValueR = 0.0;
+    if (Token == numt) {
+        if (Lexeme.find('.') != string_view::npos) {
+            value.ValueR = ValueR;
+        } else {
+            value.Value = Value;
+        }
+    } else if (Token == idt && atoms != nullptr) {
+        value.Ident = atoms->Intern(Lexeme);
+    }
+    tokens.SetSource(source.Data(), source.Base());
+    tokens.Append(Token, TokenOffset(), TokenLength(), value);
+}
+
+void LexicalAnalyzer::Tokenize(TokenStream& tokens, int threads)
+{
+    const char* text = source.Data();
+    size_t size = source.Size();
+    size_t chunks = min<size_t>(max(threads, 1), size / minChunkSize);
+    if (chunks <= 1 || pos != 0 || source.Streaming()) {
+        TokenizeSerial(tokens);
+        return;
+    }
+
+    // Cut just after a newline. String literals and comments both end at the
+    // end of their line, so every line start is also a token boundary and a
+    // chunk lexer starting there is in the same state as the serial lexer.
+    vector<size_t> bounds{0};
+    for (size_t c = 1; c < chunks; c++) {
+        size_t cut = FindLineEnd(text, max(size * c / chunks, bounds.back()), size);
+        if (cut + 1 >= size) {
+            break;
+        }
+        bounds.push_back(cut + 1);
+    }
+    bounds.push_back(size);
+    chunks = bounds.size() - 1;
+
+    struct Chunk {
+        TokenStream tokens;
+        ostringstream diag;     // errors are held back and printed in order
+        int errors = 0;
+    };
+    vector<Chunk> results(chunks);
+    auto lexChunk = [&](size_t c) {
+        LexicalAnalyzer chunk(text + bounds[c], bounds[c + 1] - bounds[c]);
+        chunk.SetDiagnostics(results[c].diag);
+        chunk.atoms = atoms;
+        chunk.TokenizeSerial(results[c].tokens);
+        results[c].errors = chunk.errors;
+    };
+    vector<thread> workers;
+    for (size_t c = 1; c < chunks; c++) {
+        workers.emplace_back(lexChunk, c);
+    }
+    lexChunk(0);
+    for (thread& worker : workers) {
+        worker.join();
+    }
+
+    // stitch the chunks together; each one but the last ends in an extra eoft
+    tokens.SetSource(text);
+    for (size_t c = 0; c < chunks; c++) {
+        *diag << results[c].diag.str();
+        errors += results[c].errors;
+        size_t count = results[c].tokens.Size() - (c + 1 < chunks ? 1 : 0);
+        tokens.AppendFrom(results[c].tokens, count, bounds[c]);
+    }
+
+    // leave this lexer where the serial one would have stopped
+    pos = size;
+    atEnd = true;
+    ch = EOF;
+    tokenStart = size;
+    Token = eoft;
+    Lexeme = "";
+}
+
+void LexicalAnalyzer::Relex(TokenStream& tokens, const TextEdit& edit)
 {
-    if (inputfile.get(ch)) {
-        if (ch == '\n') {
-            LineNo++;
+    const char* text = source.Data();
+    size_t editEnd = edit.offset + edit.inserted.size();   // end of the edit in the new text
+    long delta = static_cast<long>(edit.inserted.size()) - static_cast<long>(edit.removed);
+
+    // Restart at the beginning of the edited line. No token runs across a
+    // newline, so every token before it is untouched by the edit.
+    size_t lineStart = edit.offset;
+    while (lineStart > 0 && text[lineStart - 1] != '\n') {
+        lineStart--;
+    }
+    size_t first = tokens.FirstAtOrAfter(lineStart);
+    atEnd = false;
+    pos = lineStart;
+    GetNextCh();
+
+    // Lex until a token starts past the edit at the same place a token
+    // started in the old text; the lexer keeps no state between tokens, so
+    // from there on the old stream is right apart from its offsets.
+    TokenStream fresh;
+    size_t old = tokens.FirstAtOrAfter(edit.offset + edit.removed);
+    for (;;) {
+        ReadToken(fresh);
+        size_t offset = fresh.Offset(fresh.Size() - 1);
+        if (offset >= editEnd) {
+            size_t oldOffset = offset - delta;
+            while (old < tokens.Size() && tokens.Offset(old) < oldOffset) {
+                old++;
+            }
+            if (old < tokens.Size() && tokens.Offset(old) == oldOffset) {
+                tokens.Splice(first, old, fresh, fresh.Size() - 1, delta);
+                break;
+            }
+        }
+        if (Token == eoft) {
+            // the old stream always ends in eoft at its end of text, so this
+            // only happens if that stream was incomplete; replace all of it
+            tokens.Splice(first, tokens.Size(), fresh, fresh.Size(), 0);
+            break;
         }
+    }
+    tokens.SetSource(text);
+}
+
+void LexicalAnalyzer::TokenizeSerial(TokenStream& tokens)
+{
+    // a rough guess of one token per six bytes saves most of the regrowing
+    tokens.Reserve(tokens.Size() + source.Size() / 6 + 1);
+    do {
+        ReadToken(tokens);
+    } while (Token != eoft);
+}
+
+void LexicalAnalyzer::GetNextCh()
+{
+    if (pos < source.Size() || Refill()) {
+        ch = source.Data()[pos++];
     } else {
         // reached end of file
         ch = EOF;
         Token = eoft;
+        atEnd = true;
     }
 }
 
-void LexicalAnalyzer::ProcessToken()
+bool LexicalAnalyzer::Refill()
 {
-    Lexeme = "";
-    Lexeme += ch; // store the first character of the lexeme
-    GetNextCh();
+    // keep the token being lexed and the oldest token the reader still holds
+    size_t keep = min(pos, tokenStart);
+    if (pinned != noToken) {
+        keep = min(keep, pinned - source.Base());
+    }
+    size_t before = source.Base();
+    size_t added = source.Refill(keep);
+    size_t shift = source.Base() - before;
+    pos -= shift;
+    if (tokenStart != noToken) {
+        tokenStart -= shift;
+    }
+    return added > 0;
+}
 
-    if (isalpha(Lexeme[0])) {
-        ProcessWordToken();
-    } else if (isdigit(Lexeme[0])) {
-        ProcessNumToken();
-    } else {
-        switch (Lexeme[0]) {
-            case '-':
-                if (ch == '-') {
-                    ProcessComment();
-                } else {
-                    ProcessSingleToken();
-                }
-                break;
-            case '"': 
-                ProcessLiteralToken();
-                break;
-            case '/': 
-                if (ch == '=') {
-                    ProcessDoubleToken(); 
-                } else {
-                    ProcessSingleToken();
-                }
-                break;
-            case ':':
-            case '<':
-            case '>':
-                if (ch == '=') {
-                    ProcessDoubleToken();
-                } else {
-                    ProcessSingleToken();
-                }
-                break;
-            default:
-                ProcessSingleToken();
+void LexicalAnalyzer::ScanRun(size_t (*scan)(const char*, size_t, size_t), size_t from)
+{
+    // move to the end of a run, reading more input while it reaches the end
+    // of the buffer
+    for (;;) {
+        size_t end = scan(source.Data(), from, source.Size());
+        bool more = end == source.Size();
+        MoveTo(end);
+        if (!more || atEnd) {
+            return;
         }
+        from = Cursor();
     }
 }
 
-void LexicalAnalyzer::ProcessWordToken()
+SourceLocation LexicalAnalyzer::Locate(size_t offset)
+{
+    if (!source.Streaming()) {
+        return lines.Locate(offset);
+    }
+    // only the buffered window of a stream is left; count from its start
+    const char* text = source.Data();
+    size_t end = min(offset - source.Base(), source.Size());
+    SourceLocation where;
+    where.line = source.LinesBefore() + 1 + count(text, text + end, '\n');
+    size_t lineStart = source.LineStartBefore();
+    for (size_t i = end; i > 0; i--) {
+        if (text[i - 1] == '\n') {
+            lineStart = source.Base() + i;
+            break;
+        }
+    }
+    where.column = offset - lineStart + 1;
+    return where;
+}
+
+void LexicalAnalyzer::MoveTo(size_t index)
 {
-    while(isalnum(ch) || ch == '_') {
-        Lexeme += ch;
+    // make source[index] the current character
+    if (index != Cursor()) {
+        pos = index;
         GetNextCh();
     }
-    string temp = ToLower(Lexeme);
-    if (IsReservedWord(temp)) {
-        Token = reservedWords[temp];
-        Lexeme = ToLower(Lexeme);
-    } else if (temp == "real") {
-        Token = reservedWords["float"];
-        Lexeme = "float";
+}
+
+void LexicalAnalyzer::SetLexeme()
+{
+    // Lexeme runs from the token start up to (not including) ch
+    Lexeme = string_view(source.Data() + tokenStart, Cursor() - tokenStart);
+}
+
+void LexicalAnalyzer::ProcessToken()
+{
+    tokenStart = Cursor(); // ch is the first character of the lexeme
+
+    switch (ClassOf(ch)) {
+        case ccLetter:
+            GetNextCh();
+            ProcessWordToken();
+            break;
+        case ccDigit:
+            GetNextCh();
+            ProcessNumToken();
+            break;
+        case ccQuote:
+            GetNextCh();
+            ProcessLiteralToken();
+            break;
+        default:
+            ProcessOperatorToken();
+    }
+}
+
+void LexicalAnalyzer::ProcessWordToken()
+{
+    ScanRun(SkipIdentifier, Cursor());
+    SetLexeme();
+    const Keyword* keyword = FindKeyword(Lexeme.data(), Lexeme.size());
+    if (keyword != nullptr) {
+        Token = keyword->token;
+        Lexeme = keyword->lexeme;   // lower case spelling owned by the table
     } else {
         Token = idt;
     }
     if (Lexeme.length() > 17) {
-        cout << "\033[31mError: identifier must be less than 18 characters\033[0m" << endl;
+        *diag << "\033[31mError: identifier must be less than 18 characters\033[0m" << endl;
+        errors++;
         Token = unknownt;
     }
 }
@@ -153,95 +360,83 @@ void LexicalAnalyzer::ProcessWordToken()
 void LexicalAnalyzer::ProcessNumToken()
 {
     bool isFloat = false;
-    while (isdigit(ch) || ch == '.') {
+    while (ClassOf(ch) == ccDigit || ch == '.') {
         if (ch == '.') {
             if (isFloat) {
-                cout << "\033[31mError: multiple decimal points in number: \033[0m";
-                cout << Lexeme << ch << endl;
+                SetLexeme();
+                *diag << "\033[31mError: multiple decimal points in number: \033[0m";
+                errors++;
+                *diag << Lexeme << ch << endl;
                 GetNextCh();
                 GetNextToken();
                 return;
             }
             isFloat = true;
         }
-        Lexeme += ch;
         GetNextCh();
     }
+    SetLexeme();
     
     if (Lexeme.back() == '.') {
-        cout << "\033[31mError: number cannot end with a decimal point: \033[0m";
-        cout << Lexeme << endl;
+        *diag << "\033[31mError: number cannot end with a decimal point: \033[0m";
+        errors++;
+        *diag << Lexeme << endl;
         GetNextCh();
         GetNextToken();
         return;
     }
     if (isFloat) {
         Token = numt;
-        ValueR = stod(Lexeme);
+        ValueR = stod(string(Lexeme));
     } else {
         Token = numt;
-        Value = stoi(Lexeme);
+        Value = stoi(string(Lexeme));
     }
 }
 
 void LexicalAnalyzer::ProcessComment()
 {
-    while (ch != '\n' && !inputfile.eof()) {
-        GetNextCh();
-    } 
-    if (inputfile.eof()) {
-        Token = eoft;
-    } 
-    // Do I need these 2 statements?
-    GetNextCh();
-    GetNextToken();
+    // ch is the first '-'; stop on the newline and let GetNextToken skip it
+    ScanRun(FindLineEnd, pos);
 }
 
-void LexicalAnalyzer::ProcessDoubleToken()
+void LexicalAnalyzer::ProcessOperatorToken()
 {
-    Lexeme += ch;
-    GetNextCh();
-    if (Lexeme == ":=") {
-        Token = assignopt;
-    } else if (Lexeme == "<=" || Lexeme == ">=" || Lexeme == "/=") {
-        Token = relopt;
-    } 
-}
-
-void LexicalAnalyzer::ProcessSingleToken()
-{
-    switch(Lexeme[0]) {
-        case '+': case '-': Token = addopt; break;
-        case '*': case '/': Token = mulopt; break;
-        case '=': case '<': case '>': Token = relopt; break;
-        case '(': Token = lparent; break;
-        case ')': Token = rparent; break;
-        case ',': Token = commat; break;
-        case ';': Token = semit; break;
-        case ':': Token = colont; break;
-        case '.': Token = periodt; break;
-        default: 
-            cout << "\033[31mError: unknown symbol: " << Lexeme[0] << "\033[0m" << endl;
-            Token = unknownt; 
+    // walk the transition table from the start state until it accepts
+    LexState state = lsStart;
+    for (;;) {
+        const LexMove& move = lexTransitions.move[state][ClassOf(ch)];
+        if (move.consume) {
+            GetNextCh();
+        }
+        if (move.next == lsAccept) {
+            Token = move.token;
             break;
+        }
+        state = move.next;
+    }
+    SetLexeme();
+    if (Token == unknownt) {
+        *diag << "\033[31mError: unknown symbol: " << Lexeme[0] << "\033[0m" << endl;
+        errors++;
     }
 }
 
 void LexicalAnalyzer::ProcessLiteralToken()
 {
-    Token = literalt;
-    while(ch!= '"') {
-        Lexeme += ch;
+    // a literal ends at the closing quote or, unterminated, at the end of the line
+    ScanRun(FindLiteralEnd, Cursor());
+    if (ch == '"') {
+        Token = literalt;
         GetNextCh();
-        if(ch == '\n') {
-            cout << "\033[31mError: unterminated string literal\033[0m" << endl;
-            Token = unknownt;
-            Literal = Lexeme;
-        }
+    } else {
+        *diag << "\033[31mError: unterminated string literal\033[0m" << endl;
+        errors++;
+        Token = unknownt;
     }
-    Lexeme += ch;
-    Literal = Lexeme;
-    GetNextCh();
+    SetLexeme();
+    // the literal outlives the buffer position, so keep an owned copy
+    Literal = string(Lexeme);
 }
 
 void LexicalAnalyzer::DisplayToken()
@@ -261,16 +456,6 @@ void LexicalAnalyzer::DisplayToken()
     cout << endl;
 }
 
-bool LexicalAnalyzer::IsReservedWord(string &s)
-{
-    auto it = reservedWords.find(s);
-    if (it != reservedWords.end()) {
-        Token = it->second;
-        return true;
-    }
-    return false;
-}
-
 string LexicalAnalyzer::GetTokenName(Symbol token)
 {
     static unordered_map<Symbol, string> tokenNames = {
@@ -284,11 +469,12 @@ string LexicalAnalyzer::GetTokenName(Symbol token)
         {colont, "colont"}, {semit, "semit"}, {periodt, "periodt"}, {numt, "numt"},
         {idt, "idt"}, {eoft, "eoft"}, {unknownt, "unknownt"}
     };
+    // the table is only read, and nothing is reported here: the parser asks
+    // for names while a pipeline's lexer thread writes its diagnostics
     auto it = tokenNames.find(token);
     if (it != tokenNames.end()) {
         return it->second;
     }
-    cout << "\033[31mError: Token not found\033[0m" << endl;
     return "UNKNOWN";
 }
 
@@ -11,13 +11,20 @@
  *   This header file declares the LexicalAnalyzer class and supporting data
  *   structures for tokenizing source code of an Ada subset. It defines the
  *   Token structure, token types, and the interface for reading and processing
- *   input from a source file.
+ *   input from a source file. The source is held in a SourceBuffer and each
+ *   Lexeme is a view into it rather than a copy.
  */
 #ifndef _LEXICALANALYZER_H
 #define _LEXICALANALYZER_H
 #include <unordered_map>
 #include <string>
+#include <string_view>
+#include <iosfwd>
+#include <cstdio>           // EOF
+#include <cstdint>
 #include <functional>       // hash
+#include "SourceBuffer.h"
+#include "LineTable.h"
 
 using namespace std;
 
@@ -28,28 +35,71 @@ enum Symbol {
     semit, periodt, numt, idt, eoft, unknownt, in, out, inout, nott
 };
 
+class TokenStream;
+class InternTable;
+
+// one edit to the source: removed bytes at offset were replaced by inserted
+struct TextEdit {
+    size_t offset;
+    size_t removed;
+    string_view inserted;
+};
+
 class LexicalAnalyzer {
     public:
 
-        LexicalAnalyzer(string name);
+        LexicalAnalyzer(string name);                       // "-" reads stdin
+        LexicalAnalyzer(const char* text, size_t length);  // lex text in memory
+        LexicalAnalyzer(int fd, size_t bufferSize);        // lex a pipe through a bounded buffer
         ~LexicalAnalyzer();
+        void SetDiagnostics(ostream& out) { diag = &out; }
+        bool Opened() const { return opened; }     // false if the file could not be read
+        int Errors() const { return errors; }      // lexical errors reported so far
+        void SetInternTable(InternTable& table) { atoms = &table; }     // atoms for ReadToken
         void GetNextToken();
-        string GetTokenName(Symbol token);
+        // a pure lookup, safe from any thread; "UNKNOWN" for a symbol it lacks
+        static string GetTokenName(Symbol token);
 
         void GetNextCh();
         void ProcessToken();
         void ProcessWordToken();
         void ProcessNumToken();
         void ProcessComment();
-        void ProcessDoubleToken();
-        void ProcessSingleToken();
+        void ProcessOperatorToken();
         void ProcessLiteralToken();
         void DisplayToken();
+        size_t TokenOffset() const { return source.Base() + tokenStart; }
+        size_t TokenLength() const { return Cursor() - tokenStart; }
+        SourceLocation Locate(size_t offset);
+        const SourceBuffer& Source() const { return source; }
+
+        // lex one more token (or the whole unit) onto the end of a token stream
+        void ReadToken(TokenStream& tokens);
+        void Tokenize(TokenStream& tokens, int threads = 1);
+        // bring a complete token stream of the text before edit up to date with
+        // this lexer's text (the text after edit), re-lexing only what changed
+        void Relex(TokenStream& tokens, const TextEdit& edit);
 
     private:  
-        bool IsReservedWord(string& s);
+        size_t Cursor() const { return atEnd ? source.Size() : pos - 1; }
+        char PeekCh() { return pos < source.Size() || Refill() ? source.Data()[pos] : EOF; }
+        bool Refill();
+        void ScanRun(size_t (*scan)(const char*, size_t, size_t), size_t from);
+        void MoveTo(size_t index);
+        void SetLexeme();
+
+        void TokenizeSerial(TokenStream& tokens);
 
-        unordered_map<string, Symbol> reservedWords;
+        SourceBuffer source;
+        LineTable lines;            // built on the first Locate
+        ostream* diag;              // where lexical errors are written
+        InternTable* atoms = nullptr;   // identifiers read into a TokenStream are interned here
+        size_t pos = 0;             // index of the character after ch
+        size_t tokenStart = 0;      // index of the first character of Lexeme
+        size_t pinned = SIZE_MAX;   // input offset of the oldest token still in use
+        bool atEnd = false;         // true once GetNextCh has run off the end
+        bool opened = true;
+        int errors = 0;             // counted wherever one is written to diag
 
         // helpers
         string ToUpper(string s);
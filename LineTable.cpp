@@ -0,0 +1,45 @@
+/*
+ * LineTable.cpp
+ *
+ * CSC 446 - Compiler Construction - Source Line Table Implementation
+ *
+ * Author: Landon Dahmen
+ *
+ * Description:
+ *   This file implements the LineTable class declared in LineTable.h.
+ */
+#include <algorithm>
+#include "LineTable.h"
+#include "CharScan.h"
+
+using namespace std;
+
+void LineTable::SetSource(const char* text, size_t length)
+{
+    source = text;
+    size = length;
+    built = false;
+    lineStarts.clear();
+}
+
+void LineTable::Build()
+{
+    lineStarts.push_back(0);
+    for (size_t i = FindLineEnd(source, 0, size); i < size; i = FindLineEnd(source, i + 1, size)) {
+        lineStarts.push_back(static_cast<uint32_t>(i + 1));
+    }
+    built = true;
+}
+
+SourceLocation LineTable::Locate(size_t offset)
+{
+    if (!built) {
+        Build();
+    }
+    // the last line starting at or before offset
+    size_t line = upper_bound(lineStarts.begin(), lineStarts.end(), offset) - lineStarts.begin();
+    SourceLocation location;
+    location.line = static_cast<uint32_t>(line);
+    location.column = static_cast<uint32_t>(offset - lineStarts[line - 1] + 1);
+    return location;
+}
@@ -0,0 +1,41 @@
+/*
+ * LineTable.h
+ *
+ * CSC 446 - Compiler Construction - Source Line Table Header
+ *
+ * Author: Landon Dahmen
+ *
+ * Description:
+ *   This header file declares the LineTable class, which turns the byte
+ *   offsets carried by tokens into line and column numbers. The lexer does
+ *   not count lines as it goes; the first lookup scans the source for
+ *   newlines once and records where every line starts, and each lookup after
+ *   that is a binary search. A compile with no diagnostics never builds it.
+ */
+#ifndef _LINETABLE_H
+#define _LINETABLE_H
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+struct SourceLocation {
+    uint32_t line;      // 1-based
+    uint32_t column;    // 1-based, in bytes
+};
+
+class LineTable {
+    public:
+        void SetSource(const char* text, size_t length);
+        SourceLocation Locate(size_t offset);
+
+    private:
+        void Build();
+
+        const char* source = "";
+        size_t size = 0;
+        bool built = false;
+        vector<uint32_t> lineStarts;    // offset of the first byte of each line
+};
+#endif
@@ -16,67 +16,151 @@
  *   and printing the correct end marker.
  */
 #include "Parser.h"
+#include "Interface.h"
 #include "Globals.h"
 #include <iostream>
 #include <sstream>
+#include <algorithm>
+#include <atomic>
+#include <thread>
 
 #define RESET "\033[0m"
 
 using namespace std;
 
-RecursiveDescentParser::RecursiveDescentParser(string name) : lex(name)
+RecursiveDescentParser::RecursiveDescentParser(string name, const ParserOptions& options)
+    : options(options), tokens(ownTokens), ownAtoms(new InternTable), atoms(*ownAtoms),
+      st(atoms), ownLex(new LexicalAnalyzer(name)), lex(*ownLex)
 {
-    this->name = name;
+    lex.SetInternTable(atoms);
+    if (options.symtabStats) {
+        st.EnableStats();
+    }
+    this->name = name == "-" ? "stdin" : name;
+    outputBase = options.outputBase;
+    if (outputBase.empty()) {
+        outputBase = this->name.substr(0, this->name.find_last_of('.'));
+    }
     Offset = 0;
     tempCounter = 0;
+    if (!lex.Opened()) {
+        error = true;       // already reported by the lexer
+        return;
+    }
+
+    // procedures of separately compiled libraries, visible everywhere
+    for (const string& path : options.interfaces) {
+        string problem;
+        if (!LoadInterface(path, st, 0, imported, problem)) {
+            cout << "Error: " << RESET << "could not load interface "
+                << path << ": " << problem << endl;
+            exit(1);
+        }
+    }
 
-    // Create TAC file with same name
-    string tacFileName = name.substr(0, name.find_last_of('.')) + ".tac";
-    tacFile.open(tacFileName);
-    if(!tacFile) {
+    // Create TAC file with same name (none at all when only checking)
+    string tacFileName = outputBase + ".tac";
+    if (!options.checkOnly) {
+        tacFile.open(tacFileName);
+    }
+    if(!options.checkOnly && !tacFile) {
         cout << "Error: " << RESET 
             << "could not open file " << tacFileName << endl;
         exit(1);
     }
     // Prime parser
-    lex.GetNextToken(); 
+    if (options.pretokenize) {
+        lex.Tokenize(tokens, options.lexThreads);
+        error = error || lex.Errors() > 0;
+    } else {
+        if (options.pipeline) {
+            pipeline.reset(new TokenPipeline(lex));
+        }
+        ReadToken();
+    }
+    LoadToken(0);
+    if (options.parseThreads > 1 && options.pretokenize && !options.symtabStats) {
+        // the counters would only see this parser's own table
+        ScanSkeleton();
+    }
     // Push start symbol onto stack
     Prog();
 
-    if (!error && !programName.empty()) {
+    if (!error && !programName.empty() && !options.checkOnly) {
         emit("start proc " + programName);
     }
     if (Token != eoft) {
+        // list the leftovers, no more of them than the error limit
+        int unused = 0;
         while(Token != eoft) {
-            cout << "Unused token: " << lex.GetTokenName(Token) << endl;
-            lex.GetNextToken(); 
+            if (options.maxErrors == 0 || unused < options.maxErrors) {
+                cout << "Unused token: " << LexicalAnalyzer::GetTokenName(Token) << endl;
+            }
+            unused++;
+            NextToken();
+        }
+        if (options.maxErrors > 0 && unused > options.maxErrors) {
+            cout << "(and " << unused - options.maxErrors << " more)" << endl;
         }
-        cout << name << ": " << LineNo+1 << ": " 
-            << "Error: " << RESET << "unused tokens!" << endl;
+        panicking = false;      // leftovers are an error of their own
+        ErrorAt() << "unused tokens!" << endl;
         error = true;
     }
     if (error) {
-        cout << name << ": "
+        // code already written for the procedures before the first error
+        // is of no use
+        if (tacFile.is_open()) {
+            tacFile.close();
+            remove((outputBase + ".tac").c_str());
+        }
+        cout << this->name << ": "
             << "Error: " << RESET << "syntax errors found!" << endl;
+    } else if (options.checkOnly) {
+        cout << "Exiting procedure " << programName << "\n\n";
+        cout << "Parsing and semantic analysis completed successfully!" << endl;
     } else {
         GenerateAssembly();
         // only your four lines:
         cout << "Exiting procedure " << programName << "\n\n";
         cout << "Parsing and semantic analysis completed successfully!" << endl;
-        // strip off “.ada” to build your filenames:
-        string base = name.substr(0, name.find_last_of('.'));
-        cout << "Three Address Code written to: " << base << ".tac" << endl;
-        cout << "Assembly Code written to: " << base << ".asm" << endl;
+        cout << "Three Address Code written to: " << outputBase << ".tac" << endl;
+        cout << "Assembly Code written to: " << outputBase << ".asm" << endl;
+        if (options.emitInterface) {
+            // the procedures declared directly inside the outer one
+            if (WriteInterface(outputBase + ".adi", st.Procedures(1))) {
+                cout << "Interface written to: " << outputBase << ".adi" << endl;
+            } else {
+                cout << "Error: " << RESET << "could not write " << outputBase << ".adi" << endl;
+            }
+        }
+    }
+    if (options.symtabStats) {
+        cout << endl;
+        st.WriteStats(cout);
     }
 }
 
+RecursiveDescentParser::RecursiveDescentParser(RecursiveDescentParser& parent,
+                                               shared_ptr<const ScopeSnapshot> scope)
+    : options(parent.options), tokens(parent.tokens), atoms(parent.atoms),
+      st(atoms, move(scope)), lex(parent.lex), parent(&parent), name(parent.name)
+{
+    // shares the parent's tokens, atoms and lexer; everything it declares
+    // stays in its own table over scope, and its code goes to tac
+    tempCounter = 0;
+    imported = parent.imported;     // so calls to them are checked here too
+}
+
 RecursiveDescentParser::~RecursiveDescentParser()
 {
 }
 
 void RecursiveDescentParser::emit(string code)
 {
-    if (tacFile.is_open()) {
+    if (parent != nullptr) {
+        tac += code;
+        tac += '\n';
+    } else if (tacFile.is_open()) {
         tacFile << code << endl;
     } else {
         cout << "Error: " << RESET 
@@ -85,10 +169,10 @@ void RecursiveDescentParser::emit(string code)
     //cout << code << endl;
 }
 
-string RecursiveDescentParser::GetVarReference(TableEntry* entry)
+string RecursiveDescentParser::GetVarReference(const TableEntry* entry)
 {
     if (entry->depth == 1) {
-        return entry->lexeme;
+        return string(entry->lexeme);
     }
 
     if (entry->isParam) {
@@ -101,8 +185,7 @@ string RecursiveDescentParser::GetVarReference(TableEntry* entry)
 TableEntry* RecursiveDescentParser::NewTemp()
 {
     string tempName = "_t" + to_string(++tempCounter);
-    st.Insert(tempName, idt, Depth);
-    TableEntry* entry = st.Lookup(tempName);
+    TableEntry* entry = st.Insert(tempName, idt, Depth);
     if (entry) {
         entry->TypeOfEntry = varEntry;
         entry->var.TypeOfVariable = intType; // Default int
@@ -112,10 +195,10 @@ TableEntry* RecursiveDescentParser::NewTemp()
         Offset += entry->var.size;
         //entry->var.Offset = Offset;
         if (Depth == 1) {
-            globalTemps.push_back(tempName);
+            globalTemps.push_back(entry->atom);
         }
     }
-    return st.Lookup(tempName);
+    return entry;
 }
 
 void RecursiveDescentParser::ProcessParams()
@@ -125,8 +208,7 @@ void RecursiveDescentParser::ProcessParams()
     int count = 1;     // This counter starts at 1 for the last element
     // Loop through the parameters vector in reverse order:
     for (int i = currentParameters.size() - 1; i >= 0; i--, count++) {
-        string lexeme = currentParameters[i];
-        TableEntry* entry = st.Lookup(lexeme);
+        TableEntry* entry = st.Modify(currentParameters[i]);
         if (entry != nullptr && entry->isParam) {
             // If the base for parameters is 2, then for the last parameter (count 1):
             //   offset = 2 + 1 * paramSize (i.e., +_BP+4)
@@ -139,95 +221,241 @@ void RecursiveDescentParser::ProcessParams()
 }
 }
 
-void RecursiveDescentParser::Match(Symbol desired)
+ostream& RecursiveDescentParser::ErrorAt()
 {
-    if (Token == desired) {
-        lex.GetNextToken();
+    error = true;
+    if (panicking || stopped) {
+        return discard;     // most likely caused by the error being recovered from
+    }
+    if (parent != nullptr) {
+        // a worker's work is thrown away after an error and done again in
+        // order, so it only has to stop: jump to the eoft at the end
+        stopped = true;
+        tokenIndex = tokens.Size() - 1;
+        LoadToken(tokenIndex);
+        return discard;
+    }
+    if (options.maxErrors > 0 && errorCount == options.maxErrors) {
+        cout << name << ": " << "Error: " << RESET << "too many errors, stopping" << endl;
+        stopped = true;
+        // nothing more is reported; run out the tokens so the parse ends
+        while (Token != eoft) {
+            NextToken();
+        }
+        return discard;
+    }
+    errorCount++;
+    // the line table is only built once the first error needs it
+    SourceLocation where = lex.Locate(tokens.Offset(tokenIndex));
+    cout << name << ": " << where.line << ":" << where.column << ": " << "Error: " << RESET;
+    return cout;
+}
+
+ostream& RecursiveDescentParser::SyntaxErrorAt()
+{
+    // report, then stay quiet until the parser is back in step with the input
+    ostream& out = ErrorAt();
+    panicking = true;
+    return out;
+}
+
+static bool IsSyncToken(Symbol token)
+{
+    return token == semit || token == ist || token == begint || token == endt
+        || token == elsift || token == elset || token == proceduret || token == eoft;
+}
+
+void RecursiveDescentParser::Synchronize()
+{
+    // panic mode: skip the rest of the statement or declaration, up to and
+    // including its semicolon, or up to a token that opens or closes a
+    // block, and report errors again from there
+    if (!panicking) {
+        return;
+    }
+    while (!IsSyncToken(Token)) {
+        NextToken();
+    }
+    if (Token == semit) {
+        NextToken();
+    }
+    panicking = false;
+}
+
+void RecursiveDescentParser::NextToken()
+{
+    tokensMatched++;
+    if (tokenIndex + 1 < tokens.Size()) {
+        tokenIndex++;
+    } else if (!options.pretokenize) {
+        // the lookahead window is used up, start it again with the next token
+        tokens.Clear();
+        tokenIndex = 0;
+        ReadToken();
+    }
+    // a pre-tokenized stream ends with eoft, which stays the current token
+    LoadToken(tokenIndex);
+}
+
+void RecursiveDescentParser::ReadToken()
+{
+    if (pipeline) {
+        pipeline->ReadToken(tokens);
+        error = error || pipeline->Errors() > 0;
     } else {
-        cout << name << ": " << LineNo+1
-            << ": " << "Error: " << RESET << "expecting: " 
-            << lex.GetTokenName(desired) << ", found " << Lexeme << endl;
-        error = true;
+        lex.ReadToken(tokens);
+        error = error || lex.Errors() > 0;
     }
 }
 
-void RecursiveDescentParser::Prog()
+Symbol RecursiveDescentParser::PeekToken(size_t ahead)
 {
-    if (Token == proceduret) {
-        Match(proceduret);
-        string procName = Lexeme;
-        if (st.Lookup(Lexeme) != nullptr) {
-            cout << name << ": " << LineNo+1 << ": " 
-                << "Error: " << RESET << "duplicate identifier: " 
-                << Lexeme << RESET << " at Depth " << Depth << endl;
-            error = true;
-            exit(1);
+    if (tokenIndex + ahead >= tokens.Size()) {
+        if (options.pretokenize) {
+            return eoft;
         }
-        if (Depth == 0) {
-            programName = procName; // Save the program name
+        while (tokenIndex + ahead >= tokens.Size() && tokens.Kind(tokens.Size() - 1) != eoft) {
+            ReadToken();
         }
+        LoadToken(tokenIndex); // lexing ahead overwrote the current token
+        if (tokenIndex + ahead >= tokens.Size()) {
+            return eoft;
+        }
+    }
+    return tokens.Kind(tokenIndex + ahead);
+}
 
-        st.Insert(Lexeme, Token, Depth);
-        TableEntry* prevProcedure = currentProcedure;
-
-        currentProcedure = st.Lookup(Lexeme);
-        currentProcedure->TypeOfEntry = functionEntry;
-        currentProcedure->function.NumberOfParameters = 0;
-        currentProcedure->function.SizeOfLocal = 0;
-        currentProcedure->function.ParamList = nullptr;
+void RecursiveDescentParser::LoadToken(size_t i)
+{
+    Token = tokens.Kind(i);
+    Lexeme = tokens.Lexeme(i);
+    if (Token == numt) {
+        if (Lexeme.find('.') != string_view::npos) {
+            ValueR = tokens.NumValue(i).ValueR;
+        } else {
+            Value = tokens.NumValue(i).Value;
+        }
+    } else if (Token == literalt) {
+        Literal = string(Lexeme);
+    }
+    currentAtom = Token == idt ? tokens.NumValue(i).Ident : noAtom;
+}
 
-        int savedOffset = Offset;
-        Offset = 2; // start stack offset at 2
-        tempCounter = 0;
-        Depth++;
+void RecursiveDescentParser::Match(Symbol desired)
+{
+    if (Token == desired) {
+        if (panicking && IsSyncToken(desired)) {
+            panicking = false;  // a separator the parser expected: back in step
+        }
+        NextToken();
+    } else {
+        SyntaxErrorAt() << "expecting: " 
+            << LexicalAnalyzer::GetTokenName(desired) << ", found " << Lexeme << endl;
+        error = true;
+    }
+}
 
-        Match(idt);
-        Args();
-        ProcessParams();
-        int paramSize = Offset; // save param space used so far
+void RecursiveDescentParser::Prog()
+{
+    if (Token == proceduret) {
+        ProcedureFrame frame = ProcedureHeading();
+        ProcedureBody(frame);
+        LeaveProcedure(frame);
+    }
+}
 
-        Match(ist);
-        DeclarativePart(); // adds locals (Offset grows)
+RecursiveDescentParser::ProcedureFrame RecursiveDescentParser::ProcedureHeading()
+{
+    // procedure idt Args: declares the procedure and its parameters and
+    // opens its scope
+    ProcedureFrame frame;
+    Match(proceduret);
+    frame.procName = string(Lexeme);
+    Atom procAtom = currentAtom;
+    bool redeclared = Depth == 1 && procAtom == predeclared;  // by a worker's parent
+    if (st.Lookup(procAtom) != nullptr && !redeclared) {
+        // reported, then compiled anyway so its body is checked too
+        ErrorAt() << "duplicate identifier: " 
+            << Lexeme << RESET << " at Depth " << Depth << endl;
+        error = true;
+    }
+    if (Depth == 0) {
+        programName = frame.procName; // Save the program name
+    }
 
-        int localsStart = paramSize; // everything after this is locals or temps
+    frame.prevProcedure = currentProcedure;
 
-        Procedures(); // nested procedures
+    currentProcedure = st.Insert(procAtom, Token, Depth, functionEntry);
+    currentProcedure->TypeOfEntry = functionEntry;
+    currentProcedure->function.NumberOfParameters = 0;
+    currentProcedure->function.SizeOfLocal = 0;
+    currentProcedure->function.ParamList = nullptr;
 
-        emit("proc " + procName);
+    frame.savedOffset = Offset;
+    Offset = 2; // start stack offset at 2
+    tempCounter = 0;
+    Depth++;
 
-        Match(begint);
-        SeqOfStatements(); // this creates temps (Offset increases again)
-        Match(endt);
-        Match(idt);
-        Match(semit);
+    Match(idt);
+    Args();
+    ProcessParams();
+    frame.paramSize = Offset; // save param space used so far
+    return frame;
+}
 
-        // calculate total space for locals + temps
-        int afterAll = Offset;
-        int localSize = afterAll - paramSize;
+void RecursiveDescentParser::ProcedureBody(const ProcedureFrame& frame)
+{
+    Match(ist);
+    DeclarativePart(); // adds locals (Offset grows)
+
+    Procedures(); // nested procedures
+
+    Match(begint);
+    NodeList body;
+    SeqOfStatements(body);
+    Match(endt);
+    Match(idt);
+    Match(semit);
+
+    // the whole body is known now; lowering it creates the temps
+    // (Offset increases again). Only checking, or once there has been an
+    // error (a lexical one included), the body is not needed once it has
+    // been parsed
+    if (options.checkOnly || error) {
+        ast.Clear();
+    } else {
+        LowerProcedure(frame.procName, body);
+    }
 
-        if (currentProcedure != nullptr) {
-            currentProcedure->function.SizeOfLocal = localSize;
-        }
+    // calculate total space for locals + temps
+    int afterAll = Offset;
+    int localSize = afterAll - frame.paramSize;
 
-        emit("endp " + procName);
-        //st.WriteTable(Depth);
-        st.DeleteDepth(Depth);
-        Depth--;
-        currentProcedure = prevProcedure;
-        Offset = savedOffset;
+    if (currentProcedure != nullptr) {
+        currentProcedure->function.SizeOfLocal = localSize;
     }
 }
 
+void RecursiveDescentParser::LeaveProcedure(const ProcedureFrame& frame)
+{
+    //st.WriteTable(Depth);
+    st.DeleteDepth(Depth);
+    Depth--;
+    currentProcedure = frame.prevProcedure;
+    Offset = frame.savedOffset;
+}
+
 
 void RecursiveDescentParser::DeclarativePart()
 {   
-    if (Token == idt) {
+    // DeclarativePart -> IdentifierList : TypeMark ; DeclarativePart | ε,
+    // one declaration per pass
+    while (Token == idt) {
         IdentifierList();
         Match(colont);
         TypeMark();
         Match(semit);
-        DeclarativePart();
-    } else {
+        Synchronize();
     }
 }
 
@@ -235,83 +463,52 @@ void RecursiveDescentParser::IdentifierList()
 {
     // IdentifierList -> idt IdentifierListPrime
     if (Token == idt) {
-        string currentLexeme = Lexeme; // Save current lexeme
-
-        TableEntry* existing = st.Lookup(currentLexeme);
-        if (existing != nullptr && existing->depth == Depth) {
-            cout << name << ": " << LineNo+1 << ": " 
-                << "Error: " << RESET << "duplicate identifier: " 
-                << currentLexeme << RESET << " at Depth: " << Depth << endl;
-            error = true;
-            exit(1);
-        } else {
-            st.Insert(currentLexeme, Token, Depth);
-            TableEntry* entry = st.Lookup(currentLexeme);
-            entry->TypeOfEntry = varEntry;
-            if(currentMode == 0) {
-                entry->paramMode = modeIn;
-            } else if(currentMode == 1) {
-                entry->paramMode = modeOut;
-            } else if(currentMode == 2) {
-                entry->paramMode = modeInOut;
-            }
-            if (processingParams && entry != nullptr) {
-                entry->isParam = true;
-                entry->function.NumberOfParameters++;
-                currentParameters.push_back(currentLexeme);
-            } else {
-                currentIdentifiers.push_back(currentLexeme);
-            }
-        }
+        DeclareIdentifier();
         Match(idt);
         IdentifierListPrime();
     } else {   
-        cout << name << ": " << LineNo+1 << ": " 
-            << "Error: " << RESET << "expecting identifier" << endl;
+        SyntaxErrorAt() << "expecting identifier" << endl;
         error = true;
     }
 }
 
 void RecursiveDescentParser::IdentifierListPrime()
 {
-    if (Token == commat) {
+    // IdentifierListPrime -> , idt IdentifierListPrime | ε, one name per pass
+    while (Token == commat) {
         Match(commat);
-        
-        string currentLexeme = Lexeme; // Save current lexeme
-        
-        // check for multiple declarations
-        TableEntry* existing = st.Lookup(currentLexeme);
-        if (existing != nullptr && existing->depth == Depth) {
-            cout << name << ": " << LineNo+1 << ": " 
-                << "Error: " << RESET << "duplicate identifier: " 
-                << currentLexeme << RESET
-                << " at Depth: " << Depth << endl;
-            error = true;
-            exit(1);
-        } else {
-            st.Insert(currentLexeme, Token, Depth);
-            TableEntry* entry = st.Lookup(currentLexeme);
-            entry->TypeOfEntry = varEntry;
-            if(currentMode == 0) {
-                entry->paramMode = modeIn;
-            } else if(currentMode == 1) {
-                entry->paramMode = modeOut;
-            } else if(currentMode == 2) {
-                entry->paramMode = modeInOut;
-            }
-            if (processingParams && entry != nullptr) {
-                entry->isParam = true;
-                entry->function.NumberOfParameters++;
-                currentParameters.push_back(currentLexeme);
-            } else {
-                currentIdentifiers.push_back(currentLexeme);
-            }
-        }
-        
+        DeclareIdentifier();
         Match(idt);
-        IdentifierListPrime();
+    }
+}
+
+void RecursiveDescentParser::DeclareIdentifier()
+{
+    Atom id = currentAtom; // Save current identifier
+
+    // check for multiple declarations
+    const TableEntry* existing = st.Lookup(id);
+    if (existing != nullptr && existing->depth == Depth) {
+        // the first declaration stands
+        ErrorAt() << "duplicate identifier: " 
+            << Lexeme << RESET << " at Depth: " << Depth << endl;
+        error = true;
     } else {
-        // ε
+        TableEntry* entry = st.Insert(id, Token, Depth);
+        entry->TypeOfEntry = varEntry;
+        if(currentMode == 0) {
+            entry->paramMode = modeIn;
+        } else if(currentMode == 1) {
+            entry->paramMode = modeOut;
+        } else if(currentMode == 2) {
+            entry->paramMode = modeInOut;
+        }
+        if (processingParams && entry != nullptr) {
+            entry->isParam = true;
+            currentParameters.push_back(id);
+        } else {
+            currentIdentifiers.push_back(id);
+        }
     }
 }
 
@@ -319,8 +516,8 @@ void RecursiveDescentParser::TypeMark()
 {
     if (Token == integert) {
         // loop through all identifiers in the list and update their type
-        for (auto& id : currentIdentifiers) {
-            TableEntry* entry = st.Lookup(id);
+        for (Atom id : currentIdentifiers) {
+            TableEntry* entry = st.Modify(id);
             if (entry) {
                 entry->var.TypeOfVariable = intType;
                 entry->var.size = size(integert);
@@ -333,8 +530,8 @@ void RecursiveDescentParser::TypeMark()
         }
         Match(integert);
     } else if (Token == floatt) {
-        for (auto& id : currentIdentifiers) {
-            TableEntry* entry = st.Lookup(id);
+        for (Atom id : currentIdentifiers) {
+            TableEntry* entry = st.Modify(id);
             if (entry) {
                 entry->var.TypeOfVariable = floatType;
                 entry->var.size = size(floatt);
@@ -347,8 +544,8 @@ void RecursiveDescentParser::TypeMark()
         }
         Match(floatt);
     } else if (Token == chart) {
-        for (auto& id : currentIdentifiers) {
-            TableEntry* entry = st.Lookup(id);
+        for (Atom id : currentIdentifiers) {
+            TableEntry* entry = st.Modify(id);
             if (entry) {
                 entry->var.TypeOfVariable = charType;
                 entry->var.size = size(chart);
@@ -361,8 +558,8 @@ void RecursiveDescentParser::TypeMark()
         }
         Match(chart);
     } else if (Token == constantt) {
-        for (auto& id : currentIdentifiers) {
-            TableEntry* entry = st.Lookup(id);
+        for (Atom id : currentIdentifiers) {
+            TableEntry* entry = st.Modify(id);
             if (entry) {
                 entry->TypeOfEntry = constEntry;
                 // set the constant type and value in the Value() function
@@ -372,9 +569,8 @@ void RecursiveDescentParser::TypeMark()
         Match(assignopt);
         Value1();
     } else {
-        cout << name << ": " << LineNo+1 << ": " 
-            << "Error: " << RESET << "expecting integert, floatt, chart, or constantt" << endl;
-        cout << "Token found: " << lex.GetTokenName(Token) << endl;
+        SyntaxErrorAt() << "expecting integert, floatt, chart, or constantt" << endl
+            << "Token found: " << LexicalAnalyzer::GetTokenName(Token) << endl;
         error = true;
     }
     // Clear the identifier list after processing
@@ -387,8 +583,8 @@ void RecursiveDescentParser::Value1()
     if (Token == numt) {
         bool isFloat = (Lexeme.find('.') != string::npos);
         
-        for (auto& id : currentIdentifiers) {
-            TableEntry* entry = st.Lookup(id);
+        for (Atom id : currentIdentifiers) {
+            TableEntry* entry = st.Modify(id);
             if (entry && entry->TypeOfEntry == constEntry) {
                 if (isFloat) {
                     entry->constant.TypeOfConstant = floatType;
@@ -406,19 +602,19 @@ void RecursiveDescentParser::Value1()
         Match(numt);
     } else {
         // Error handling
-        cout << name << ": " << LineNo+1 << ": " 
-            << "Error: " << RESET << "expecting numerical literal" << endl;
+        SyntaxErrorAt() << "expecting numerical literal" << endl;
         error = true;
     }
 }
 
 void RecursiveDescentParser::Procedures()
 {
-    if (Token == proceduret) {
+    // Procedures -> Prog Procedures | ε, one procedure per pass
+    if (Depth == 1 && !siblings.empty() && !error && CompileSiblings()) {
+        return;
+    }
+    while (Token == proceduret) {
         Prog();
-        Procedures();
-    } else {
-        // ε
     }
 }
 
@@ -438,43 +634,40 @@ void RecursiveDescentParser::Args()
 
 void RecursiveDescentParser::ArgList()
 {
-    if (Token == in || Token == out || Token == inout || Token == idt) {
+    // ArgList -> Mode IdentifierList : TypeMark MoreArgs, and
+    // MoreArgs -> ; ArgList | ε, one group of parameters per pass
+    for (;;) {
+        if (Token != in && Token != out && Token != inout && Token != idt) {
+            SyntaxErrorAt() << "expecting in, out, inout, or idt" << endl;
+            error = true;
+            return;
+        }
         // process mode if present
         if (Token == in || Token == out || Token == inout) {
             Mode();
         }
         
         // before processing identifiers, save the current count
-        int startCount = currentIdentifiers.size();
+        size_t startCount = currentParameters.size();
         
         // process identifiers
         IdentifierList();
 
-        // calculate how many new identifiers were added
-        int paramCount = currentIdentifiers.size() - startCount;
-        
-        // update the procedure's parameter count
+        Match(colont);
+        VarType type = Token == floatt ? floatType : Token == chart ? charType : intType;
+
+        // record the new parameters in the procedure's parameter list
         if (currentProcedure != nullptr) {
-            currentProcedure->function.NumberOfParameters += paramCount;
+            for (size_t i = startCount; i < currentParameters.size(); i++) {
+                const TableEntry* entry = st.Lookup(currentParameters[i]);
+                st.AddParam(currentProcedure, type, entry != nullptr ? entry->paramMode : none);
+            }
         }
-        
-        Match(colont);
         TypeMark();
-        MoreArgs();
-    } else {
-        cout << name << ": " << LineNo+1 << ": " 
-            << "Error: " << RESET << "expecting in, out, inout, or idt" << endl;
-        error = true;
-    }
-}
-
-void RecursiveDescentParser::MoreArgs()
-{
-    if (Token == semit) {
+        if (Token != semit) {
+            return;
+        }
         Match(semit);
-        ArgList();
-    } else {
-        // ε
     }
 }
 
@@ -494,133 +687,174 @@ void RecursiveDescentParser::Mode()
     }
 }
 
-void RecursiveDescentParser::SeqOfStatements()
+void RecursiveDescentParser::SeqOfStatements(NodeList& body)
 {
     // SeqOfStatements -> Statement ; StatTail | ε
-    if(Token == idt || Token == ift || Token == whilet || Token == begint 
-        || Token == gett || Token == putt || Token == putlnt) {
-        Statement();
-        Match(semit);
-        StatTail();
-    } else {
-        // ε
-    }
+    StatTail(body);
 }
 
-void RecursiveDescentParser::StatTail()
+void RecursiveDescentParser::StatTail(NodeList& body)
 {
-    // StatTail -> Statement ; StatTail | ε
-    if(Token == idt || Token == ift || Token == whilet || Token == begint
-        || Token == gett || Token == putt || Token == putlnt) {
-        Statement();
-        Match(semit);
-        StatTail();
-    } else {
-        // ε
+    // StatTail -> Statement ; StatTail | ε, one statement per pass; anything
+    // else before the end of the sequence is reported and skipped
+    while (Token != endt && Token != elsift && Token != elset && Token != eoft) {
+        size_t before = tokensMatched;
+        if (Token == idt || Token == ift || Token == whilet || Token == begint
+            || Token == gett || Token == putt || Token == putlnt) {
+            ast.Append(body, Statement());
+            Match(semit);
+        } else {
+            SyntaxErrorAt() << "expecting a statement, found " << Lexeme << endl;
+        }
+        Synchronize();
+        if (tokensMatched == before) {
+            NextToken();    // stuck on a token that opens a block; drop it
+        }
     }
 }
 
-void RecursiveDescentParser::Statement()
+NodeIndex RecursiveDescentParser::Statement()
 {
-    // Statement -> AssignStat | IOStat
+    // Statement -> AssignStat | IfStat | WhileStat | IOStat
     if (Token == idt) {
-        AssignStat();
+        return AssignStat();
+    } else if (Token == ift) {
+        return IfStat();
+    } else if (Token == whilet) {
+        return WhileStat();
     } else {
-        IOStat();
+        return IOStat();
+    }
+}
+
+NodeIndex RecursiveDescentParser::IfStat()
+{
+    // IfStat -> if Expr then SeqOfStatements {elsif Expr then SeqOfStatements}
+    //           [else SeqOfStatements] end if, the elsif arms in a loop
+    vector<pair<NodeIndex, NodeList>> arms;
+    do {
+        Match(Token);   // if or elsif
+        NodeIndex condition = Expr();
+        Match(thent);
+        NodeList statements;
+        SeqOfStatements(statements);
+        arms.emplace_back(condition, statements);
+    } while (Token == elsift);
+    NodeList otherwise;
+    if (Token == elset) {
+        Match(elset);
+        SeqOfStatements(otherwise);
+    }
+    Match(endt);
+    Match(ift);
+
+    // each elsif is the else part of the arm before it
+    NodeIndex elsePart = otherwise.first;
+    for (size_t i = arms.size(); i-- > 0;) {
+        elsePart = ast.AddIf(arms[i].first, arms[i].second.first, elsePart);
     }
+    return elsePart;
 }
 
-void RecursiveDescentParser::AssignStat() {
-    // AssignStat -> idt := Expr
+NodeIndex RecursiveDescentParser::WhileStat()
+{
+    // WhileStat -> while Expr loop SeqOfStatements end loop
+    NodeIndex start = ast.NextIndex();
+    Match(whilet);
+    NodeIndex condition = Expr();
+    Match(loopt);
+    NodeList body;
+    SeqOfStatements(body);
+    Match(endt);
+    Match(loopt);
+    return ast.AddWhile(start, condition, body.first);
+}
+
+NodeIndex RecursiveDescentParser::AssignStat() {
+    // AssignStat -> idt := Expr | idt ( Params )
     if (Token == idt) {
-        TableEntry* entry = st.Lookup(Lexeme);
+        const TableEntry* entry = st.Lookup(currentAtom);
         if (entry == nullptr) {
-            cout << name << ": " << LineNo+1 << ": "
-                << "Error: " << RESET << "undeclared identifier: " 
+            // the rest of the statement is still parsed and checked
+            ErrorAt() << "undeclared identifier: " 
                 << Lexeme << RESET << " at Depth: " << Depth << endl;
             error = true;
-            return;
         }
-        
-        // Prepare left-hand side based on depth
-        string leftSide;
 
-        leftSide = GetVarReference(entry);
-
-        string idName = Lexeme; // Save for ProcCall check
+        // the token after the name tells a procedure call from an assignment
+        if (PeekToken(1) == lparent) {
+            Match(idt);
+            NodeIndex call = ProcCall(entry);
+            return entry != nullptr ? call : noNode;
+        }
+        
         Match(idt);
         
         if (Token == assignopt) {
             Match(assignopt);
-            string rightSide = Expr();
-            emit(leftSide + " = " + rightSide);
-        } else if (Token == lparent) {
-            // This is a procedure call, call the ProcCall method
-            ProcCall(idName);
+            NodeIndex value = Expr();
+            return entry != nullptr ? ast.AddEntry(assignNode, entry, value) : noNode;
         }
     } else {
-        cout << name << ": " << LineNo+1 << ": "
-            << "Error: " << RESET << "expecting identifier" << endl;
+        SyntaxErrorAt() << "expecting identifier" << endl;
         error = true;
     }
+    return noNode;
 }
 
-void RecursiveDescentParser::IOStat()
+NodeIndex RecursiveDescentParser::IOStat()
 {
     // IOStat -> In_Stat | Out_Stat
     if (Token == gett) {
-        InStat();
+        return InStat();
     } else if (Token == putt || Token == putlnt) {
-        OutStat();
+        return OutStat();
     } else {
-        cout << name << ": " << LineNo+1 << ": "
-             << "Error: " << RESET << "expecting get, put, or putln" << endl;
+        SyntaxErrorAt() << "expecting get, put, or putln" << endl;
         error = true;
+        return noNode;
     }
 }
 
-void RecursiveDescentParser::InStat()
+NodeIndex RecursiveDescentParser::InStat()
 {
     // In_Stat -> get ( IdList )
+    NodeList names;
     Match(gett);
     Match(lparent);  
-    IdList();        
+    IdList(names);        
     Match(rparent);    
+    return ast.Add(getNode, names.first);
 }
 
-void RecursiveDescentParser::IdList()
+void RecursiveDescentParser::IdList(NodeList& names)
 {
-    if (Token == idt) {
-        string varName = Lexeme;
-        TableEntry* entry = st.Lookup(varName);
+    // IdList -> idt IdListTail, and IdListTail -> , IdList | ε, one name per pass
+    for (;;) {
+        if (Token != idt) {
+            SyntaxErrorAt() << "expecting identifier in IdList" << endl;
+            error = true;
+            return;
+        }
+        string varName(Lexeme);
+        const TableEntry* entry = st.Lookup(currentAtom);
 
         if (entry == nullptr) {
-            cout << name << ": " << LineNo+1 << ": "
-                 << "Error: " << RESET << "undeclared identifier: " << varName << RESET << endl;
+            ErrorAt() << "undeclared identifier: " << varName << RESET << endl;
             error = true;
         } else {
-            emit("rdi " + GetVarReference(entry)); // Emit TAC
+            ast.Append(names, ast.AddEntry(nameNode, entry));
         }
 
         Match(idt);
-        IdListTail();
-    } else {
-        cout << name << ": " << LineNo+1 << ": "
-             << "Error: " << RESET << "expecting identifier in IdList" << endl;
-        error = true;
-    }
-}
-
-void RecursiveDescentParser::IdListTail()
-{
-    if (Token == commat) {
+        if (Token != commat) {
+            return;
+        }
         Match(commat);
-        IdList();
     }
-    // else ε
 }
 
-void RecursiveDescentParser::OutStat()
+NodeIndex RecursiveDescentParser::OutStat()
 {
     bool isPutln = false;
 
@@ -630,164 +864,175 @@ void RecursiveDescentParser::OutStat()
 
     Match(Token);  // Match put or putln
 
+    NodeList items;
     Match(lparent);
-    WriteList();
+    WriteList(items);
     Match(rparent);
 
-    if (isPutln) {
-        emit("wrln");
-    }
+    return ast.Add(putNode, items.first, noNode, isPutln ? putLine : 0);
 }
 
-void RecursiveDescentParser::WriteList()
+void RecursiveDescentParser::WriteList(NodeList& items)
 {
-    WriteToken();
-    WriteListTail();
+    WriteToken(items);
+    WriteListTail(items);
 }
 
-void RecursiveDescentParser::WriteListTail()
+void RecursiveDescentParser::WriteListTail(NodeList& items)
 {
-    if (Token == commat) {
+    // WriteListTail -> , WriteToken WriteListTail | ε, one item per pass
+    while (Token == commat) {
         Match(commat);
-        WriteToken();
-        WriteListTail();
+        WriteToken(items);
     }
-    // else ε
 }
 
-void RecursiveDescentParser::WriteToken()
+void RecursiveDescentParser::WriteToken(NodeList& items)
 {
     if (Token == idt) {
-        TableEntry* entry = st.Lookup(Lexeme);
+        const TableEntry* entry = st.Lookup(currentAtom);
         if (entry == nullptr) {
-            cout << name << ": " << LineNo+1 << ": "
-                 << "Error: " << RESET << "undeclared identifier: " << Lexeme << RESET << endl;
+            ErrorAt() << "undeclared identifier: " << Lexeme << RESET << endl;
             error = true;
         } else {
-            emit("wri " + GetVarReference(entry));
+            ast.Append(items, ast.AddEntry(nameNode, entry));
         }
         Match(idt);
     } else if (Token == numt) {
-        emit("wri " + Lexeme);
+        ast.Append(items, ast.AddText(numberNode, Lexeme));
         Match(numt);
     } else if (Token == literalt) {
-        string label = InsertStringLiteral(Lexeme);  // You will create this next
-        emit("wrs " + label);
+        ast.Append(items, ast.AddText(stringNode, Literal));
         Match(literalt);
     } else {
-        cout << name << ": " << LineNo+1 << ": "
-             << "Error: " << RESET << "expecting id, num, or literal in WriteToken" << endl;
+        SyntaxErrorAt() << "expecting id, num, or literal in WriteToken" << endl;
         error = true;
     }
 }
 
-string RecursiveDescentParser::Expr()
+static bool FitsInWord(int value)
 {
-    // IOStat -> Relation
-    return Relation();
+    return value >= INT16_MIN && value <= INT16_MAX;
 }
 
-string RecursiveDescentParser::Relation() {
-    // Relation -> SimpleExpr
-    string leftOperand = SimpleExpr();
-    
-    if (Token == relopt) {
-        string op = Lexeme; // Save the relational operator
-        Match(Token);
-        string rightOperand = SimpleExpr();
-        TableEntry* temp = NewTemp();
-        emit(GetVarReference(temp) + " = " + leftOperand + " " + op + " " + rightOperand);
-        return GetVarReference(temp);
+// binding power of a binary operator, 0 for a token that is not one
+static int Precedence(Symbol token)
+{
+    switch (token) {
+        case relopt:
+            return relationPrecedence;
+        case addopt:
+            return 2;
+        case mulopt:
+            return 3;
+        default:
+            return 0;
     }
-    
-    return leftOperand;
 }
 
-string RecursiveDescentParser::SimpleExpr()
+static bool IsRelation(string_view op)
+{
+    return op == "=" || op == "/=" || op == "<" || op == "<=" || op == ">" || op == ">=";
+}
+
+// the relation that holds exactly when op does not
+static string Complement(string_view op)
+{
+    return op == "=" ? "/=" : op == "/=" ? "=" : op == "<" ? ">=" : op == ">=" ? "<"
+        : op == ">" ? "<=" : ">";
+}
+
+// operators whose code cannot fault, so a loop may work them out before
+// it knows it will run
+static bool Hoistable(string_view op)
+{
+    return op == "+" || op == "-" || op == "*" || IsRelation(op);
+}
+
+// a local or temporary of the procedure being lowered, which only its own
+// statements can change
+static bool Private(const TableEntry* entry)
+{
+    return entry->depth > 1 && !entry->isParam;
+}
+
+// the condition code of a signed comparison, for j<cc> and set<cc>
+static string ConditionCode(string_view op)
 {
-    // SimpleExpr -> Term MoreTerm
-    string result = Term();
-    return MoreTerm(result);
+    return op == "=" ? "e" : op == "/=" ? "ne" : op == "<" ? "l" : op == "<=" ? "le"
+        : op == ">" ? "g" : "ge";
 }
 
-string RecursiveDescentParser::MoreTerm(const string& inherited) {
-    // MoreTerm -> addopt Term MoreTerm | ε
-    if (Token == addopt) {
-        string op = Lexeme; // Save the operator (+ - or)
+NodeIndex RecursiveDescentParser::Expr()
+{
+    // Expr -> Relation, Relation -> SimpleExpr [relopt SimpleExpr],
+    // SimpleExpr -> Term {addopt Term}, Term -> Factor {mulopt Factor}:
+    // all three levels by precedence climbing rather than a call per level
+    return Climb(Factor(), relationPrecedence);
+}
+
+NodeIndex RecursiveDescentParser::Climb(NodeIndex left, int minPrecedence)
+{
+    // take operators of at least minPrecedence, left to right; one that
+    // binds tighter than the operator before it takes that right operand
+    while (Precedence(Token) >= minPrecedence) {
+        int precedence = Precedence(Token);
+        string op(Lexeme); // Save the operator
         Match(Token);
-        string rightOperand = Term();
-        TableEntry* temp = NewTemp();
-        emit(GetVarReference(temp) + " = " + inherited + " " + op + " " + rightOperand);
-        return MoreTerm(GetVarReference(temp));
-    } else {
-        return inherited; // No more operations, return what we have
+        NodeIndex rightOperand = Factor();
+        while (Precedence(Token) > precedence) {
+            rightOperand = Climb(rightOperand, precedence + 1);
+        }
+        left = Binary(op, left, rightOperand);
+        if (precedence == relationPrecedence) {
+            break;      // relations do not chain
+        }
     }
+    return left;
 }
-    
-string RecursiveDescentParser::Term() {
-    // Term -> Factor MoreFactor
-    string result = Factor();
-    return MoreFactor(result);
-}
-   
-string RecursiveDescentParser::MoreFactor(const string& inherited) {
-    // MoreFactor -> mulopt Factor MoreFactor | ε
-    if (Token == mulopt) {
-        string op = Lexeme; // Save the operator (* / mod rem and)
-        Match(mulopt);
-        string rightOperand = Factor();
-        TableEntry* temp = NewTemp();
-        emit(GetVarReference(temp) + " = " + inherited + " " + op + " " + rightOperand);
-        return MoreFactor(GetVarReference(temp));
-    } else {
-        return inherited; // No more operations, return what we have
+
+NodeIndex RecursiveDescentParser::Binary(const string& op, NodeIndex left, NodeIndex right)
+{
+    // + - * of two known integers is worked out now, wrapped to 16 bits as
+    // the add, sub and imul the assembly would use; the other operators
+    // have no code generated for them to agree with, so they are left alone
+    if (ast.Foldable(left) && ast.Foldable(right) && (op == "+" || op == "-" || op == "*")) {
+        int a = ast[left].value, b = ast[right].value;
+        int16_t result = static_cast<int16_t>(op == "+" ? a + b : op == "-" ? a - b : a * b);
+        return ast.AddNumber(to_string(result), result);
     }
+    return ast.AddText(binaryNode, op, left, right);
 }
 
-string RecursiveDescentParser::Factor() {
-    string result;
+    
+   
+NodeIndex RecursiveDescentParser::Factor() {
+    NodeIndex result;
     if (Token == idt) {
         // Get identifier from symbol table
-        TableEntry* entry = st.Lookup(Lexeme);
+        const TableEntry* entry = st.Lookup(currentAtom);
         if (entry == nullptr) {
-            cout << name << ": " << LineNo+1 << ": " 
-                << "Error: " << RESET << "undeclared identifier: " 
+            ErrorAt() << "undeclared identifier: " 
                 << Lexeme << RESET << " at Depth: " << Depth << endl;
             error = true;
-            return "";
+            Match(idt);
+            return ast.AddEntry(nameNode, nullptr);
         }
-        
-        // If depth == 1, use variable name directly, else use offset notation
-        if (entry->TypeOfEntry == constEntry) {
+        if (entry->TypeOfEntry == constEntry && entry->constant.TypeOfConstant == intType
+            && FitsInWord(entry->constant.Value)) {
             // Directly substitute constant values
-            if (entry->constant.TypeOfConstant == intType) {
-                result = to_string(entry->constant.Value);
-            } else {
-                result = to_string(entry->constant.ValueR);
-            }
-        } else if (entry->depth == 1) {
-            result = Lexeme;
+            result = ast.AddNumber(to_string(entry->constant.Value), entry->constant.Value);
         } else {
-            // Handle variables at deeper depths with offset notation
-            if (entry->TypeOfEntry == varEntry) {
-                // Parameters use positive offsets
-                if (entry->depth == 1) {
-                    result = entry->lexeme; // global — use name
-                } else {
-                    if (entry->TypeOfEntry == varEntry) {
-                        if (entry->isParam) {
-                            result = "_BP+" + to_string(entry->var.Offset);  // parameter
-                        } else {
-                            result = "_BP-" + to_string(entry->var.Offset);  // local or temp
-                        }
-                    }
-                }
-            }
+            result = ast.AddEntry(nameNode, entry);
         }
         Match(idt);
     } else if (Token == numt) {
-        // For number literals, just return the value
-        result = Lexeme;
+        // For number literals, keep the number as written
+        if (Lexeme.find('.') == string_view::npos && FitsInWord(Value)) {
+            result = ast.AddNumber(Lexeme, Value);
+        } else {
+            result = ast.AddText(numberNode, Lexeme);
+        }
         Match(numt);
     } else if (Token == lparent) {
         Match(lparent);
@@ -795,132 +1040,829 @@ string RecursiveDescentParser::Factor() {
         Match(rparent);
     } else if (Token == nott) {
         Match(nott);
-        string operand = Factor();
-        TableEntry* temp = NewTemp();
-        emit(GetVarReference(temp) + " = not " + operand);
-        result = GetVarReference(temp);
+        result = ast.Add(notNode, Factor());
     } else if (Token == addopt) {
-        string op = Lexeme; // Save the operator (+ or -)
+        string op(Lexeme); // Save the operator (+ or -)
         Match(addopt);
-        string operand = Factor();
-        if (op == "-") {
-            TableEntry* temp = NewTemp();
-            emit(GetVarReference(temp) + " = -" + operand);
-            result = GetVarReference(temp);
+        NodeIndex operand = Factor();
+        if (op == "-" && ast.Foldable(operand)) {
+            int16_t negated = static_cast<int16_t>(-ast[operand].value);
+            result = ast.AddNumber(to_string(negated), negated);
+        } else if (op == "-") {
+            result = ast.Add(negateNode, operand);
         } else {
             // For + unary operator, just return the operand
             result = operand;
         }
     } else {
-        cout << name << ": " << LineNo+1 << ": " 
-            << "Error: " << RESET << "expecting identifier, number, '(', 'not', or sign operator" << endl;
+        SyntaxErrorAt() << "expecting identifier, number, '(', 'not', or sign operator" << endl;
         error = true;
-        return "";
+        return ast.AddEntry(nameNode, nullptr);
     }
     
     return result;
 }
 
-void RecursiveDescentParser::ProcCall(const string& procName) {
+NodeIndex RecursiveDescentParser::ProcCall(const TableEntry* proc) {
+    NodeList args;
     Match(lparent);
-    Params();
+    int count = Params(args);
     Match(rparent);
+    if (proc != nullptr) {
+        for (const TableEntry* entry : imported) {
+            if (entry->atom == proc->atom) {
+                CheckImportedCall(proc, args.first, count);
+            }
+        }
+    }
     
-    // Generate call instruction
-    emit("call " + procName);
+    return ast.AddEntry(callNode, proc, args.first);
 }
 
-void RecursiveDescentParser::Params() {
-    if (Token == idt) {
-        TableEntry* entry = st.Lookup(Lexeme);
-        if (entry == nullptr) {
-            cout << name << ": " << LineNo+1 << ": " 
-                << "Error: " << RESET << "undeclared identifier: " 
-                << Lexeme << RESET << " at Depth: " << Depth << endl;
+void RecursiveDescentParser::CheckImportedCall(const TableEntry* proc, NodeIndex args, int count)
+{
+    // the library was compiled on its own, so its parameter records are all
+    // that says how it may be called
+    if (count != proc->function.NumberOfParameters) {
+        ErrorAt() << "wrong number of arguments to " << proc->lexeme << RESET
+            << ": expected " << proc->function.NumberOfParameters << ", found " << count << endl;
+        error = true;
+        return;
+    }
+    int found = 0;
+    for (NodeIndex a = args; a != noNode; a = ast[a].next) {
+        found++;
+    }
+    if (found != count) {
+        return;     // an undeclared argument has been reported already
+    }
+    int position = 1;
+    for (const ParamNode* param = proc->function.ParamList; param != nullptr;
+         param = param->next, args = ast[args].next, position++) {
+        const TableEntry* entry = ast[args].entry;
+        bool name = ast[args].kind == nameNode;
+        bool variable = name && entry->TypeOfEntry == varEntry;
+        bool constant = name && entry->TypeOfEntry == constEntry;
+        if (name && !variable && !constant) {
+            // a procedure name: its entry holds no type to compare
+            ErrorAt() << "argument " << position << " of " << proc->lexeme << RESET
+                << " is not a value" << endl;
             error = true;
-            return;
-        }
-        
-        string paramName;
-        if (entry->depth == 1) {
-            paramName = Lexeme;
-        } else {
-            if (entry->TypeOfEntry == varEntry) {
-                if (entry->isParam) {
-                    paramName = "_BP+" + to_string(entry->var.Offset);
-                } else {
-                    paramName = "_BP-" + to_string(entry->var.Offset);
-                }
+        } else if ((param->mode == modeOut || param->mode == modeInOut) && !variable) {
+            ErrorAt() << "argument " << position << " of " << proc->lexeme << RESET
+                << " is out or in out and must be a variable" << endl;
+            error = true;
+        } else if (name) {
+            VarType type = variable ? entry->var.TypeOfVariable : entry->constant.TypeOfConstant;
+            if (type != param->typeOfParameter) {
+                ErrorAt() << "argument " << position << " of " << proc->lexeme << RESET
+                    << " has the wrong type" << endl;
+                error = true;
             }
         }
-        
-        // Check for parameter mode
-        if (entry->paramMode = modeOut) {
-            emit("push @" + paramName);
-        } else {
-            emit("push " + paramName);
-        }
-        
-        Match(idt);
-        ParamsTail();
-    } else if (Token == numt) {
-        // For number literals, just push the value
-        emit("push " + Lexeme);
-        Match(numt);
-        ParamsTail();
     }
 }
 
-void RecursiveDescentParser::ParamsTail() {
-    if (Token == commat) {
-        Match(commat);
-        
+int RecursiveDescentParser::Params(NodeList& args) {
+    // Params -> (idt | numt) ParamsTail, and ParamsTail -> , Params | ε,
+    // one argument per pass
+    int count = 0;
+    for (;;) {
+        count++;
         if (Token == idt) {
-            TableEntry* entry = st.Lookup(Lexeme);
+            const TableEntry* entry = st.Lookup(currentAtom);
             if (entry == nullptr) {
-                cout << name << ": " << LineNo+1 << ": " 
-                    << "Error: " << RESET << "undeclared identifier: " 
+                ErrorAt() << "undeclared identifier: " 
                     << Lexeme << RESET << " at Depth: " << Depth << endl;
                 error = true;
-                return;
-            }
-            
-            string paramName;
-            if (entry->depth == 1) {
-                paramName = Lexeme;
-            } else {
-                if (entry->TypeOfEntry == varEntry) {
-                    if (entry->isParam) {
-                        paramName = "_BP+" + to_string(entry->var.Offset);
-                    } else {
-                        paramName = "_BP-" + to_string(entry->var.Offset);
-                    }
-                }
-            }
-            
-            
-            if (entry->paramMode == modeOut) {
-                emit("push @" + paramName);
             } else {
-                emit("push " + paramName);
+                ast.Append(args, ast.AddEntry(nameNode, entry));
             }
-            
             Match(idt);
-            ParamsTail();
         } else if (Token == numt) {
-            // For number literals, just push the value
-            emit("push " + Lexeme);
+            ast.Append(args, ast.AddText(numberNode, Lexeme));
             Match(numt);
-            ParamsTail();
+        } else {
+            return count - 1;
+        }
+        if (Token != commat) {
+            return count;   // we're done with parameters
+        }
+        Match(commat);
+    }
+}
+
+/*
+ * Lowering: each procedure body is turned into three address code only once
+ * it has been parsed whole. Operands are evaluated left to right and a
+ * temporary is made for each operator after its operands, as the parser
+ * used to do while it read them, so the temporaries and the code are the
+ * same.
+ */
+void RecursiveDescentParser::LowerProcedure(const string& procName, const NodeList& body)
+{
+    emit("proc " + procName);
+    loweringName = procName;
+    labelCounter = 0;
+    for (NodeIndex s = body.first; s != noNode; s = ast[s].next) {
+        LowerStatement(s);
+    }
+    emit("endp " + procName);
+    ast.Clear();
+}
+
+void RecursiveDescentParser::LowerStatement(NodeIndex s)
+{
+    const AstNode& node = ast[s];
+    switch (node.kind) {
+        case assignNode: {
+            string leftSide = GetVarReference(node.entry);
+            emit(leftSide + " = " + LowerExpr(node.left));
+            break;
+        }
+        case callNode:
+            for (NodeIndex a = node.left; a != noNode; a = ast[a].next) {
+                if (ast[a].kind == numberNode) {
+                    emit("push " + string(ast.Text(a)));
+                    continue;
+                }
+                const TableEntry* entry = ast[a].entry;
+                // the first argument has always been passed by address, and
+                // marks the variable out for the calls after this one
+                if (a == node.left) {
+                    MarkOut(entry);
+                }
+                emit("push " + OutPrefix(entry) + OperandReference(entry));
+            }
+            emit("call " + string(node.entry->lexeme));
+            break;
+        case getNode:
+            for (NodeIndex n = node.left; n != noNode; n = ast[n].next) {
+                emit("rdi " + GetVarReference(ast[n].entry));
+            }
+            break;
+        case putNode:
+            for (NodeIndex n = node.left; n != noNode; n = ast[n].next) {
+                if (ast[n].kind == nameNode) {
+                    emit("wri " + GetVarReference(ast[n].entry));
+                } else if (ast[n].kind == numberNode) {
+                    emit("wri " + string(ast.Text(n)));
+                } else {
+                    emit("wrs " + InsertStringLiteral(string(ast.Text(n))));
+                }
+            }
+            if (node.flags & putLine) {
+                emit("wrln");
+            }
+            break;
+        case ifNode: {
+            // if c then A elsif d then B else C end if becomes
+            //     if not c goto L2; A; goto L1; L2: if not d goto L3; B; goto L1; L3: C; L1:
+            // with an elsif chain followed in a loop
+            string end = NewLabel();
+            for (NodeIndex arm = s; ;) {
+                NodeIndex elsePart = ast[arm].elsePart;
+                string otherwise = elsePart == noNode ? end : NewLabel();
+                LowerCondition(ast[arm].left, otherwise);
+                for (NodeIndex t = ast[arm].right; t != noNode; t = ast[t].next) {
+                    LowerStatement(t);
+                }
+                if (elsePart == noNode) {
+                    break;
+                }
+                emit("goto " + end);
+                emit(otherwise + ":");
+                if (ast[elsePart].kind == ifNode && ast[elsePart].next == noNode) {
+                    arm = elsePart;     // elsif
+                    continue;
+                }
+                for (NodeIndex t = elsePart; t != noNode; t = ast[t].next) {
+                    LowerStatement(t);
+                }
+                break;
+            }
+            emit(end + ":");
+            break;
+        }
+        case whileNode:
+            LowerWhile(s);
+            break;
+        default:
+            break;
+    }
+}
+
+string RecursiveDescentParser::LowerExpr(NodeIndex e)
+{
+    if (!loopValues.empty()) {
+        auto known = loopValues.find(e);
+        if (known != loopValues.end()) {
+            return known->second;
+        }
+    }
+    const AstNode& node = ast[e];
+    switch (node.kind) {
+        case nameNode: {
+            const TableEntry* entry = node.entry;
+            if (entry == nullptr) {
+                return "";      // already reported as undeclared
+            }
+            if (entry->TypeOfEntry == constEntry) {
+                // Directly substitute constant values
+                if (entry->constant.TypeOfConstant == intType) {
+                    return to_string(entry->constant.Value);
+                }
+                return to_string(entry->constant.ValueR);
+            }
+            return OperandReference(node.entry);
+        }
+        case numberNode:
+            return string(ast.Text(e));
+        case binaryNode: {
+            // a + b + c ... nests to the left; walk down that spine in a loop
+            // so only parentheses and right operands deepen the recursion
+            size_t base = spine.size();
+            NodeIndex leftmost = e;
+            while (ast[leftmost].kind == binaryNode
+                   && (loopValues.empty() || loopValues.count(leftmost) == 0)) {
+                spine.push_back(leftmost);
+                leftmost = ast[leftmost].left;
+            }
+            string result = LowerExpr(leftmost);
+            for (size_t i = spine.size(); i-- > base;) {
+                NodeIndex b = spine[i];
+                string rightOperand = LowerExpr(ast[b].right);
+                TableEntry* temp = NewTemp();
+                emit(GetVarReference(temp) + " = " + result + " " + string(ast.Text(b))
+                     + " " + rightOperand);
+                result = GetVarReference(temp);
+            }
+            spine.resize(base);
+            return result;
+        }
+        case notNode: {
+            string operand = LowerExpr(node.left);
+            TableEntry* temp = NewTemp();
+            emit(GetVarReference(temp) + " = not " + operand);
+            return GetVarReference(temp);
+        }
+        case negateNode: {
+            string operand = LowerExpr(node.left);
+            TableEntry* temp = NewTemp();
+            emit(GetVarReference(temp) + " = -" + operand);
+            return GetVarReference(temp);
+        }
+        default:
+            return "";
+    }
+}
+
+void RecursiveDescentParser::LowerCondition(NodeIndex e, const string& label, bool whenTrue)
+{
+    // jump to label if e holds (whenTrue) or unless it does. A relation is
+    // compared and jumped on directly, with no temporary for its value;
+    // anything else is compared with 0. Each not in front swaps the test.
+    bool onHolds = whenTrue;
+    while (ast[e].kind == notNode && loopValues.count(e) == 0) {
+        onHolds = !onHolds;
+        e = ast[e].left;
+    }
+    if (ast[e].kind == binaryNode && IsRelation(ast.Text(e)) && loopValues.count(e) == 0) {
+        string left = LowerExpr(ast[e].left);
+        string right = LowerExpr(ast[e].right);
+        string op = onHolds ? string(ast.Text(e)) : Complement(ast.Text(e));
+        emit("if " + left + " " + op + " " + right + " goto " + label);
+    } else {
+        string value = LowerExpr(e);
+        emit("if " + value + (onHolds ? " /= 0" : " = 0") + " goto " + label);
+    }
+}
+
+void RecursiveDescentParser::LowerWhile(NodeIndex w)
+{
+    // while c loop B end loop is laid out with its test at the bottom, so a
+    // pass runs one conditional jump and no goto:
+    //         the invariant expressions, and the first value of each reduced
+    //         product
+    //         goto L2
+    //     L1: B, each reduced product stepped after its variable's increment
+    //     L2: if c goto L1
+    vector<Induction> inductions;
+    vector<NodeIndex> worked;       // what the optimisation adds to loopValues
+    if (options.optimizeLoops) {
+        OptimizeLoop(w, inductions, worked);
+    }
+    string body = NewLabel();
+    string test = NewLabel();
+    emit("goto " + test);
+    emit(body + ":");
+    for (NodeIndex s = ast[w].right; s != noNode; s = ast[s].next) {
+        LowerStatement(s);
+        for (const Induction& induction : inductions) {
+            if (induction.increment == s) {
+                for (const string& line : induction.steps) {
+                    emit(line);
+                }
+            }
+        }
+    }
+    emit(test + ":");
+    LowerCondition(ast[w].left, body, true);
+    for (NodeIndex n : worked) {
+        loopValues.erase(n);
+    }
+}
+
+void RecursiveDescentParser::OptimizeLoop(NodeIndex w, vector<Induction>& inductions,
+                                          vector<NodeIndex>& worked)
+{
+    // emits, ahead of loop w, the code of its invariant expressions and the
+    // first value of each product of an induction variable, and records in
+    // loopValues where the body will find them
+    NodeIndex start = ast[w].loopStart;
+
+    // what the loop writes. A call may change any variable not private to
+    // this procedure, and a parameter passed by address may be any of them,
+    // so writing one may change another
+    unordered_map<const TableEntry*, int> writes;
+    int sharedWritten = 0;
+    bool paramWritten = false;
+    bool calls = false;
+    auto Write = [&](const TableEntry* entry) {
+        if (entry != nullptr && writes[entry]++ == 0 && !Private(entry)) {
+            sharedWritten++;
+            paramWritten |= entry->isParam;
+        }
+    };
+    // a variable the loop only changes where it writes it by name
+    auto Unaliased = [&](const TableEntry* entry) {
+        return Private(entry) || (!calls && !paramWritten && !(entry->isParam && sharedWritten > 0))
+            || (!calls && sharedWritten == 1 && writes.count(entry) != 0);
+    };
+    for (NodeIndex n = start; n < w; n++) {
+        const AstNode& node = ast[n];
+        if (node.kind == assignNode) {
+            Write(node.entry);
+        } else if (node.kind == getNode || node.kind == callNode) {
+            calls |= node.kind == callNode;
+            for (NodeIndex a = node.left; a != noNode; a = ast[a].next) {
+                if (ast[a].kind == nameNode) {
+                    Write(ast[a].entry);
+                }
+            }
+        }
+    }
+
+    // invariant: the node has the same value on every pass. Children come
+    // before their parents, so one pass in index order settles them all
+    vector<uint8_t> invariant(w - start);
+    auto Invariant = [&](NodeIndex n) { return n >= start && n < w && invariant[n - start]; };
+    for (NodeIndex n = start; n < w; n++) {
+        const AstNode& node = ast[n];
+        bool same = false;
+        if (loopValues.count(n) != 0) {
+            same = true;        // worked out by an enclosing loop, outside this one
+        } else if (node.kind == numberNode) {
+            same = true;
+        } else if (node.kind == nameNode && node.entry != nullptr) {
+            same = node.entry->TypeOfEntry == constEntry
+                || (writes.count(node.entry) == 0 && Unaliased(node.entry));
+        } else if (node.kind == binaryNode) {
+            same = Hoistable(ast.Text(n)) && Invariant(node.left) && Invariant(node.right);
+        } else if (node.kind == notNode || node.kind == negateNode) {
+            same = Invariant(node.left);
+        }
+        invariant[n - start] = same;
+    }
+
+    // hoist the largest invariant expressions. A relation tested as a
+    // condition is left where it is, being a compare and jump either way,
+    // though its operands are not. Parents are seen before their children
+    // here, so each tells its children whether they are part of it
+    vector<uint8_t> stays(w - start);       // tested as a condition
+    auto Tested = [&](NodeIndex c) {
+        for (; Invariant(c) && ast[c].kind == notNode; c = ast[c].left) {
+            stays[c - start] = 1;
+        }
+        if (Invariant(c) && ast[c].kind == binaryNode && IsRelation(ast.Text(c))) {
+            stays[c - start] = 1;
+        }
+    };
+    Tested(ast[w].left);
+    vector<uint8_t> within(w - start);      // part of a larger invariant
+    for (NodeIndex n = w; n-- > start;) {
+        const AstNode& node = ast[n];
+        if (node.kind == ifNode || node.kind == whileNode) {
+            Tested(node.left);
+        } else if (node.kind == binaryNode || node.kind == notNode || node.kind == negateNode) {
+            if (within[n - start] || (Invariant(n) && !stays[n - start])) {
+                within[node.left - start] = 1;
+                if (node.kind == binaryNode) {
+                    within[node.right - start] = 1;
+                }
+            }
+        }
+    }
+    for (NodeIndex n = start; n < w; n++) {
+        NodeKind kind = ast[n].kind;
+        if ((kind == binaryNode || kind == notNode || kind == negateNode) && Invariant(n)
+            && !stays[n - start] && !within[n - start] && loopValues.count(n) == 0) {
+            loopValues[n] = LowerExpr(n);
+            worked.push_back(n);
+        }
+    }
+
+    // induction variables: written once a pass, by i := i + c or i - c at
+    // the top level of the body
+    for (NodeIndex s = ast[w].right; s != noNode; s = ast[s].next) {
+        const AstNode& node = ast[s];
+        if (node.kind != assignNode || writes[node.entry] != 1 || !Unaliased(node.entry)) {
+            continue;
+        }
+        const AstNode& value = ast[node.left];
+        if (value.kind != binaryNode) {
+            continue;
         }
+        string_view op = ast.Text(node.left);
+        const AstNode& left = ast[value.left];
+        const AstNode& right = ast[value.right];
+        if ((op == "+" || op == "-") && left.kind == nameNode && left.entry == node.entry
+            && ast.Foldable(value.right)) {
+            inductions.push_back({node.entry, s, op == "+" ? right.value : -right.value, {}});
+        } else if (op == "+" && ast.Foldable(value.left) && right.kind == nameNode
+                   && right.entry == node.entry) {
+            inductions.push_back({node.entry, s, left.value, {}});
+        }
+    }
+
+    // reduce i * k, k invariant, to a temporary that starts at i * k and
+    // has the step of i times k added to it after each increment of i
+    struct Product {
+        const TableEntry* entry;
+        string factor;
+        string value;
+    };
+    vector<Product> products;
+    for (NodeIndex n = start; n < w && !inductions.empty(); n++) {
+        const AstNode& node = ast[n];
+        if (node.kind != binaryNode || ast.Text(n) != "*" || loopValues.count(n) != 0) {
+            continue;
+        }
+        Induction* induction = nullptr;
+        NodeIndex factorNode = noNode;
+        for (Induction& candidate : inductions) {
+            if (ast[node.left].kind == nameNode && ast[node.left].entry == candidate.entry
+                && Invariant(node.right)) {
+                induction = &candidate;
+                factorNode = node.right;
+            } else if (ast[node.right].kind == nameNode && ast[node.right].entry == candidate.entry
+                       && Invariant(node.left)) {
+                induction = &candidate;
+                factorNode = node.left;
+            }
+        }
+        if (induction == nullptr) {
+            continue;
+        }
+        string factor = LowerExpr(factorNode);
+        auto same = find_if(products.begin(), products.end(), [&](const Product& p) {
+            return p.entry == induction->entry && p.factor == factor;
+        });
+        if (same != products.end()) {
+            loopValues[n] = same->value;
+            worked.push_back(n);
+            continue;
+        }
+        string value = GetVarReference(NewTemp());
+        emit(value + " = " + OperandReference(induction->entry) + " * " + factor);
+        int step = induction->step;
+        if (ast.Foldable(factorNode)) {
+            int16_t by = static_cast<int16_t>(step * ast[factorNode].value);
+            if (by != 0) {
+                induction->steps.push_back(value + " = " + value
+                    + (by < 0 ? " - " + to_string(-by) : " + " + to_string(by)));
+            }
+        } else {
+            string by = factor;
+            if (step != 1 && step != -1) {
+                by = GetVarReference(NewTemp());
+                emit(by + " = " + factor + " * " + to_string(abs(step)));
+            }
+            induction->steps.push_back(value + " = " + value + (step < 0 ? " - " : " + ") + by);
+        }
+        products.push_back({induction->entry, factor, value});
+        loopValues[n] = value;
+        worked.push_back(n);
+    }
+}
+
+string RecursiveDescentParser::NewLabel()
+{
+    // numbered per procedure and named after it, so labels are unique in
+    // the program however its procedures were compiled
+    return "_L" + to_string(++labelCounter) + "_" + loweringName;
+}
+
+string RecursiveDescentParser::OperandReference(const TableEntry* entry)
+{
+    // globals by name, variables by offset; a procedure or a local constant
+    // has no address to give
+    if (entry->depth == 1 || entry->TypeOfEntry == varEntry) {
+        return GetVarReference(entry);
+    }
+    return "";
+}
+
+void RecursiveDescentParser::MarkOut(const TableEntry* entry)
+{
+    if (parent != nullptr && entry->depth <= 1) {
+        // an outer variable is shared with the other workers; the parent
+        // marks it when it stitches this worker's code in
+        if (find(markedOut.begin(), markedOut.end(), entry->atom) == markedOut.end()) {
+            markedOut.push_back(entry->atom);
+        }
+        return;
+    }
+    // the parameter or variable was declared here, so the table holds it
+    TableEntry* own = st.Modify(entry->atom);
+    if (own != nullptr) {
+        own->paramMode = modeOut;
+    }
+}
+
+string RecursiveDescentParser::OutPrefix(const TableEntry* entry)
+{
+    if (entry->paramMode == modeOut) {
+        return "@";
+    }
+    if (parent != nullptr && entry->depth <= 1) {
+        if (find(markedOut.begin(), markedOut.end(), entry->atom) != markedOut.end()) {
+            return "@";
+        }
+        // a procedure compiled before this one may still have passed it
+        // out; decided for the line emitted next when it is stitched
+        fixups.push_back({tac.size(), entry->atom, ""});
+    }
+    return "";
+}
+
+/*
+ * Parallel compilation. With parseThreads above one, ScanSkeleton walks the
+ * tokens once, before parsing, to find where each procedure declared
+ * directly in the outer one begins and ends. When the outer parser reaches
+ * those procedures, CompileSiblings declares their headings in order, then
+ * hands each whole procedure to a worker parser on a pool of threads. A
+ * worker has its own symbol table over a snapshot of the outer scope and
+ * its own code buffer; nothing it does is seen by the others. The results
+ * are stitched in source order: the procedures are declared in this table,
+ * their code is written out, and the few lines that depend on the
+ * procedures before them (string literal labels, and whether an outer
+ * variable has been passed out yet) are finished then. The files are the
+ * same as a serial compile's.
+ *
+ * The plan is only made when nothing a worker cannot see would change its
+ * result. Any error in the workers, or anything the pre-scan does not
+ * expect, and the procedures are compiled serially as before, so the
+ * messages are exactly the serial ones.
+ */
+bool RecursiveDescentParser::ScanSkeleton()
+{
+    // the outer heading and declarations, up to its first procedure
+    if (tokens.Kind(0) != proceduret) {
+        return false;
+    }
+    size_t i = 1;
+    while (tokens.Kind(i) != proceduret && tokens.Kind(i) != begint) {
+        if (tokens.Kind(i) == eoft) {
+            return false;
+        }
+        i++;
+    }
+    vector<vector<Atom>> nested;
+    while (tokens.Kind(i) == proceduret) {
+        nested.emplace_back();
+        size_t last = SkipProcedure(i, nested.back());
+        if (last == 0) {
+            siblings.clear();
+            return false;
+        }
+        siblings.push_back({i, last, 0});
+        i = last;
+    }
+    if (siblings.size() < 2 || tokens.Kind(i) != begint) {
+        siblings.clear();
+        return false;
+    }
+
+    // A worker sees the outer names and every sibling heading. It must not
+    // use a sibling declared after its own, which the serial parser would
+    // not know yet, nor anything named like a procedure nested in an
+    // earlier sibling, which the serial parser would still find (procedures
+    // are never deleted). The mode of a parameter without one carries over
+    // from the last parameter that had one.
+    vector<int> sibling(atoms.Count() + 1, -1), owner(atoms.Count() + 1, -1);
+    for (size_t k = 0; k < siblings.size(); k++) {
+        sibling[tokens.NumValue(siblings[k].first + 1).Ident] = static_cast<int>(k);
+    }
+    int mode = 0;
+    auto scan = [&](size_t from, size_t to, int k) {
+        for (size_t t = from; t < to; t++) {
+            Symbol token = tokens.Kind(t);
+            if (token == in || token == out || token == inout) {
+                mode = token == in ? 0 : token == out ? 1 : 2;
+            } else if (token == idt) {
+                Atom atom = tokens.NumValue(t).Ident;
+                if ((owner[atom] >= 0 && owner[atom] < k) || sibling[atom] > k) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    };
+    bool planned = scan(0, siblings.front().first, -1);
+    for (size_t k = 0; planned && k < siblings.size(); k++) {
+        siblings[k].modeBefore = mode;
+        planned = scan(siblings[k].first, siblings[k].last, static_cast<int>(k));
+        for (Atom atom : nested[k]) {
+            owner[atom] = static_cast<int>(k);
+        }
+    }
+    modeAfterSiblings = mode;
+    if (!planned || !scan(siblings.back().last, tokens.Size(), static_cast<int>(siblings.size()))) {
+        siblings.clear();
+        return false;
+    }
+    return true;
+}
+
+size_t RecursiveDescentParser::SkipProcedure(size_t i, vector<Atom>& nested)
+{
+    // procedure idt ... is declarations procedures begin statements end idt ;
+    // by token kinds alone; returns the index past it, or 0 if it is not
+    // shaped like that
+    i++;
+    if (tokens.Kind(i) != idt) {
+        return 0;
+    }
+    i++;
+    while (tokens.Kind(i) != proceduret && tokens.Kind(i) != begint) {
+        if (tokens.Kind(i) == eoft) {
+            return 0;
+        }
+        i++;
+    }
+    while (tokens.Kind(i) == proceduret) {
+        nested.push_back(tokens.NumValue(i + 1).Ident);
+        i = SkipProcedure(i, nested);
+        if (i == 0) {
+            return 0;
+        }
+    }
+    if (tokens.Kind(i) != begint) {
+        return 0;
+    }
+    // the body ends at the first end that does not close an if or a loop
+    for (i++; tokens.Kind(i) != endt || tokens.Kind(i + 1) == ift || tokens.Kind(i + 1) == loopt; i++) {
+        if (tokens.Kind(i) == eoft || tokens.Kind(i) == proceduret || tokens.Kind(i) == begint) {
+            return 0;
+        }
+    }
+    if (tokens.Kind(i + 1) != idt || tokens.Kind(i + 2) != semit) {
+        return 0;
+    }
+    return i + 3;
+}
+
+bool RecursiveDescentParser::CompileSiblings()
+{
+    if (tokenIndex != siblings.front().first) {
+        return false;
+    }
+    // the headings first, in order, in a table of their own so that nothing
+    // here changes until every worker has succeeded
+    RecursiveDescentParser headings(*this, st.Snapshot());
+    headings.Depth = Depth;
+    headings.DeclareSiblings(siblings);
+    vector<TableEntry*> declared = headings.st.Procedures(Depth);
+    if (headings.error || declared.size() != siblings.size()) {
+        LoadToken(tokenIndex);  // the headings were read on this thread
+        return false;
+    }
+    shared_ptr<const ScopeSnapshot> scope = headings.st.Snapshot();
+
+    vector<unique_ptr<RecursiveDescentParser>> workers(siblings.size());
+    atomic<size_t> next(0);
+    auto work = [&]() {
+        for (size_t k = next++; k < siblings.size(); k = next++) {
+            workers[k].reset(new RecursiveDescentParser(*this, scope));
+            workers[k]->predeclared = declared[k]->atom;
+            workers[k]->CompileSibling(siblings[k]);
+        }
+    };
+    vector<thread> pool;
+    for (int t = 1; t < min<int>(options.parseThreads, siblings.size()); t++) {
+        pool.emplace_back(work);
+    }
+    work();
+    for (thread& worker : pool) {
+        worker.join();
+    }
+    LoadToken(tokenIndex);
+    for (const auto& worker : workers) {
+        if (worker->error) {
+            return false;
+        }
+    }
+
+    for (size_t k = 0; k < siblings.size(); k++) {
+        Stitch(*workers[k], *declared[k]);
+    }
+    // leave things as the serial parser would after the last one
+    tempCounter = workers.back()->tempCounter;
+    currentMode = modeAfterSiblings;
+    tokensMatched += siblings.back().last - tokenIndex;
+    tokenIndex = siblings.back().last;
+    LoadToken(tokenIndex);
+    return true;
+}
+
+void RecursiveDescentParser::DeclareSiblings(const vector<SiblingRange>& ranges)
+{
+    for (const SiblingRange& range : ranges) {
+        tokenIndex = range.first;
+        LoadToken(tokenIndex);
+        currentMode = range.modeBefore;
+        ProcedureFrame frame = ProcedureHeading();
+        if (Token != ist) {
+            error = true;
+        }
+        LeaveProcedure(frame);
+    }
+}
+
+void RecursiveDescentParser::CompileSibling(const SiblingRange& range)
+{
+    tokenIndex = range.first;
+    LoadToken(tokenIndex);
+    currentMode = range.modeBefore;
+    Depth = 1;
+    Prog();
+    if (tokenIndex != range.last) {
+        error = true;   // the pre-scan and the parser disagree
+    }
+}
+
+void RecursiveDescentParser::Stitch(RecursiveDescentParser& worker, const TableEntry& heading)
+{
+    // declare the procedure, then everything nested in it, as the worker
+    // left them
+    Adopt(heading, worker.st.Procedures(Depth).front()->function.SizeOfLocal);
+    for (int depth = Depth + 1; ; depth++) {
+        vector<TableEntry*> nested = worker.st.Procedures(depth);
+        if (nested.empty()) {
+            break;
+        }
+        for (const TableEntry* procedure : nested) {
+            Adopt(*procedure, procedure->function.SizeOfLocal);
+        }
+    }
+
+    // its code, finishing the lines that waited for the procedures before it
+    size_t written = 0;
+    for (const TacFixup& fixup : worker.fixups) {
+        size_t end = worker.tac.find('\n', fixup.offset);
+        string line = worker.tac.substr(fixup.offset, end - fixup.offset);
+        tacFile.write(worker.tac.data() + written, fixup.offset - written);
+        if (fixup.argument == noAtom) {
+            emit(line + InsertStringLiteral(fixup.literal));
+        } else {
+            // line is "push " and the operand
+            const TableEntry* entry = st.Lookup(fixup.argument);
+            emit(line.insert(5, OutPrefix(entry)));
+        }
+        written = end + 1;
+    }
+    tacFile.write(worker.tac.data() + written, worker.tac.size() - written);
+    for (Atom atom : worker.markedOut) {
+        MarkOut(st.Lookup(atom));
+    }
+}
+
+void RecursiveDescentParser::Adopt(const TableEntry& procedure, int sizeOfLocal)
+{
+    TableEntry* entry = st.Insert(procedure.atom, procedure.token, procedure.depth, functionEntry);
+    entry->function.NumberOfParameters = 0;
+    entry->function.SizeOfLocal = sizeOfLocal;
+    entry->function.ParamList = nullptr;
+    for (const ParamNode* param = procedure.function.ParamList; param != nullptr; param = param->next) {
+        st.AddParam(entry, param->typeOfParameter, param->mode);
     }
-    // If not comma, we're done with parameters
 }
 
 void RecursiveDescentParser::GenerateAssembly()
 {
-    ifstream tacInput(name.substr(0, name.find_last_of('.')) + ".tac");
-    ofstream asmOutput(name.substr(0, name.find_last_of('.')) + ".asm");
+    ifstream tacInput(outputBase + ".tac");
+    ofstream asmOutput(outputBase + ".asm");
 
     if (!tacInput.is_open() || !asmOutput.is_open()) {
         cout << "Error: " << RESET << "Could not open TAC or ASM file" << endl;
@@ -946,11 +1888,11 @@ void RecursiveDescentParser::WriteDataSection(ofstream& asmOutput)
     for (const auto& [label, text] : stringLiterals) {
         asmOutput << label << " DB \"" << text << "\",\"$\"\n";
     }
-    for (const auto& var : globalVars) {
-        asmOutput << var << " DW ?\n";
+    for (Atom var : globalVars) {
+        asmOutput << atoms.Name(var) << " DW ?\n";
     }
-    for (const string& temp : globalTemps) {
-        asmOutput << temp << " DW ?\n";
+    for (Atom temp : globalTemps) {
+        asmOutput << atoms.Name(temp) << " DW ?\n";
     }
     
     asmOutput << endl;
@@ -959,7 +1901,29 @@ void RecursiveDescentParser::WriteDataSection(ofstream& asmOutput)
 void RecursiveDescentParser::WriteCodeSection(ofstream& asmOutput, ifstream& tacInput)
 {
     asmOutput << ".code\n";
-    asmOutput << "include io.asm\n\n";
+    // io.asm is assembled into the program only: a library module uses its
+    // routines, and a program that calls a library makes them public
+    if (options.emitInterface) {
+        asmOutput << "EXTRN writestr:NEAR, writeint:NEAR, writeln:NEAR, readint:NEAR\n\n";
+    } else {
+        asmOutput << "include io.asm\n\n";
+        if (!imported.empty()) {
+            asmOutput << "PUBLIC writestr, writeint, writeln, readint\n";
+        }
+    }
+
+    // procedures shared with separately assembled modules
+    if (options.emitInterface) {
+        for (const TableEntry* entry : st.Procedures(1)) {
+            asmOutput << "PUBLIC " << entry->lexeme << "\n";
+        }
+    }
+    for (const TableEntry* entry : imported) {
+        asmOutput << "EXTRN " << entry->lexeme << ":NEAR\n";
+    }
+    if (options.emitInterface || !imported.empty()) {
+        asmOutput << "\n";
+    }
 
     string line;
     while (getline(tacInput, line)) {
@@ -992,6 +1956,11 @@ void RecursiveDescentParser::ParseTacLine(const string& line, ofstream& asmOutpu
     else if (word == "start") {
         string dummy, procName;
         iss >> dummy >> procName;
+        if (options.emitInterface) {
+            // a library module has no entry point of its own
+            asmOutput << "END\n";
+            return;
+        }
         asmOutput << "start PROC\n";
         asmOutput << "mov ax, @data\nmov ds, ax\n";
         asmOutput << "call " << procName << "\n";
@@ -1024,6 +1993,22 @@ void RecursiveDescentParser::ParseTacLine(const string& line, ofstream& asmOutpu
         iss >> procName;
         asmOutput << "call " << procName << "\n";
     }
+    else if (word == "if") {
+        // if a op b goto label: a compare and one conditional jump
+        string left, op, right, dummy, label;
+        iss >> left >> op >> right >> dummy >> label;
+        asmOutput << "mov ax, " << ResolveAddress(left) << "\n";
+        asmOutput << "cmp ax, " << ResolveAddress(right) << "\n";
+        asmOutput << "j" << ConditionCode(op) << " " << label << "\n";
+    }
+    else if (word == "goto") {
+        string label;
+        iss >> label;
+        asmOutput << "jmp " << label << "\n";
+    }
+    else if (!word.empty() && word.back() == ':') {
+        asmOutput << word << "\n";
+    }
     else if (line.find('=') != string::npos) {
         HandleAssignment(line, asmOutput);
     }
@@ -1034,15 +2019,20 @@ void RecursiveDescentParser::ParseTacLine(const string& line, ofstream& asmOutpu
 
 string RecursiveDescentParser::InsertStringLiteral(string literal)
 {
-    static int stringCounter = 0;
-    string label = "_S" + to_string(stringCounter++);
+    if (parent != nullptr) {
+        // labels are numbered in the order of the whole program, so a
+        // worker's are given when its code is stitched in
+        fixups.push_back({tac.size(), noAtom, literal});
+        return "";
+    }
+    // numbered per parser, so several parsers in one process agree
+    string label = "_S" + to_string(stringLiterals.size());
 
     string cleaned = literal.substr(1, literal.length() - 2);
     stringLiterals.emplace_back(label, cleaned);
 
     if (st.Lookup(label) == nullptr) {
-        st.Insert(label, idt, 1); // insert at depth 1
-        TableEntry* entry = st.Lookup(label);
+        TableEntry* entry = st.Insert(label, idt, 1); // insert at depth 1
         entry->TypeOfEntry = varEntry;
         entry->var.TypeOfVariable = charType;
         entry->var.size = literal.length() + 1; // plus 1 for the '$'
@@ -1088,6 +2078,11 @@ void RecursiveDescentParser::HandleAssignment(const string& line, ofstream& asmO
     } else if (op == "*") {
         asmOutput << "mov bx, " << ResolveAddress(right) << "\n";
         asmOutput << "imul bx\n";
+    } else if (IsRelation(op)) {
+        // a relation's value: 1 if it holds, else 0
+        asmOutput << "cmp ax, " << ResolveAddress(right) << "\n";
+        asmOutput << "mov ax, 0\n";
+        asmOutput << "set" << ConditionCode(op) << " al\n";
     } else {
         asmOutput << "; unsupported operator: " << op << "\n";
     }
@@ -12,37 +12,94 @@
  *   for recursive descent parsing of the language. It now includes prototypes
  *   for functions that generate three-address code (TAC) as well as members for
  *   storing TAC output.
+ *
+ *   Statements and expressions are parsed into an Ast, one procedure body at
+ *   a time, and the Lower functions turn each body into TAC once its end has
+ *   been reached. A while loop is lowered with its test at the bottom, after
+ *   its invariant expressions are moved out of it and the products of its
+ *   induction variables are reduced to additions.
+ *
+ *   With parseThreads above one, the procedures declared directly in the
+ *   outer one may each be compiled by a worker parser of their own, on a
+ *   pool of threads, and stitched back in source order.
  */
 #ifndef _Parser_H
 #define _Parser_H
 #include "LexicalAnalyzer.h"
+#include "InternTable.h"
 #include "SymbolTable.h"
+#include "Ast.h"
+#include "TokenStream.h"
+#include "TokenPipeline.h"
 #include <string>
 #include <fstream>
 #include <iostream>
 #include <vector>
+#include <memory>
+#include <unordered_map>
 
 using namespace std;
 
+const int relationPrecedence = 1;     // the loosest binding operators
+
+struct ParserOptions {
+    bool pretokenize = false;   // lex the whole unit before parsing starts
+    int lexThreads = 1;         // threads used to pretokenize a large unit
+    bool pipeline = false;      // lex on a second thread while parsing
+    string outputBase;          // names the .tac and .asm files; default from the input name
+    bool emitInterface = false; // also write a .adi of the procedures for other programs
+    vector<string> interfaces;  // .adi files whose procedures may be called
+    bool symtabStats = false;   // report symbol table counters when done
+    int maxErrors = 20;         // stop after reporting this many errors; 0 for no limit
+    bool checkOnly = false;     // report errors only: no TAC, assembly or interface
+    int parseThreads = 1;       // compile the outer procedure's procedures on this many threads
+    bool optimizeLoops = true;  // move invariants out of while loops and reduce their products
+};
+
 class RecursiveDescentParser {
     public:
-        RecursiveDescentParser(string name);
+        RecursiveDescentParser(string name, const ParserOptions& options = ParserOptions());
         ~RecursiveDescentParser();
+        bool HadErrors() const { return error; }    // the run failed: no outputs were left
 
     private:
+        // a worker, compiling one of parent's procedures in scope
+        RecursiveDescentParser(RecursiveDescentParser& parent, shared_ptr<const ScopeSnapshot> scope);
+
+        ParserOptions options;
+        TokenStream ownTokens;
+        TokenStream& tokens;    // whole unit, or just the lookahead window; a worker's is its parent's
+        size_t tokenIndex = 0;  // index of the current token in tokens
+        size_t tokensMatched = 0;   // tokens consumed so far
+        Atom currentAtom = noAtom;  // the current token's atom, if it is an identifier
+        void NextToken();
+        void ReadToken();       // one more token onto the lookahead window
+        Symbol PeekToken(size_t ahead);
+        void LoadToken(size_t i);
+        ostream& ErrorAt();    // starts an error message at the current token
+        ostream& SyntaxErrorAt();   // the same, and enters panic mode
+        void Synchronize();     // leaves panic mode at the next safe token
+        bool panicking = false; // errors are not reported while set
+        bool stopped = false;   // maxErrors were reported
+        int errorCount = 0;
+        ostream discard{nullptr};   // where unreported errors go
         ofstream tacFile;
         int tempCounter;
         string programName;
         void emit(string code);
-        string GetVarReference(TableEntry* entry);
+        string GetVarReference(const TableEntry* entry);
         TableEntry* NewTemp();
+        unique_ptr<InternTable> ownAtoms;   // a worker has none of these two
+        InternTable& atoms;     // shared by the lexer and st
         SymbolTable st;
-        LexicalAnalyzer lex;
+        unique_ptr<LexicalAnalyzer> ownLex;
+        LexicalAnalyzer& lex;
+        unique_ptr<TokenPipeline> pipeline;     // set in pipelined mode; stops before lex goes
         int Depth = 0;
         int Offset = 2;
         int ParamOffset = 0;
-        vector<string> currentIdentifiers; // To keep track of identifiers being processed
-        vector<string> currentParameters; // To keep track of parameters being processed
+        vector<Atom> currentIdentifiers; // To keep track of identifiers being processed
+        vector<Atom> currentParameters; // To keep track of parameters being processed
         void ProcessParams();
         int currentMode = 0; // 0 = in, 1 = out, 2 = inout
         TableEntry* currentProcedure = nullptr; // To keep track of current procedure
@@ -50,38 +107,68 @@ class RecursiveDescentParser {
         string currentProcName = ""; //Assignment 8
         void Match(Symbol desired);
         void Prog();
+        struct ProcedureFrame {     // what Prog keeps between a heading and the end
+            string procName;
+            TableEntry* prevProcedure;
+            int savedOffset;
+            int paramSize;          // Offset after the parameters
+        };
+        ProcedureFrame ProcedureHeading();
+        void ProcedureBody(const ProcedureFrame& frame);
+        void LeaveProcedure(const ProcedureFrame& frame);
         void DeclarativePart();
         void IdentifierList();
         void IdentifierListPrime();
+        void DeclareIdentifier();
         void TypeMark();
         void Value1();
         void Procedures();
         void Args();
         void ArgList();
-        void MoreArgs();
         void Mode();
-        void SeqOfStatements();
-        void StatTail();
-        void Statement();
-        void AssignStat();
-        void IOStat();
-        void InStat();
-        void IdList();
-        void IdListTail();
-        void OutStat();
-        void WriteList();
-        void WriteListTail();
-        void WriteToken();
-        string Expr();
-        string Relation();
-        string SimpleExpr();
-        string MoreTerm(const string& inherited);
-        string Term();
-        string MoreFactor(const string& inherited);
-        string Factor();
-        void ProcCall(const string& procName);
-        void Params();
-        void ParamsTail();
+        void SeqOfStatements(NodeList& body);
+        void StatTail(NodeList& body);
+        NodeIndex Statement();
+        NodeIndex AssignStat();
+        NodeIndex IfStat();
+        NodeIndex WhileStat();
+        NodeIndex IOStat();
+        NodeIndex InStat();
+        void IdList(NodeList& names);
+        NodeIndex OutStat();
+        void WriteList(NodeList& items);
+        void WriteListTail(NodeList& items);
+        void WriteToken(NodeList& items);
+        NodeIndex Expr();
+        NodeIndex Climb(NodeIndex left, int minPrecedence);
+        NodeIndex Binary(const string& op, NodeIndex left, NodeIndex right);
+        NodeIndex Factor();
+        NodeIndex ProcCall(const TableEntry* proc);
+        int Params(NodeList& args);     // arguments read, undeclared ones too
+        void CheckImportedCall(const TableEntry* proc, NodeIndex args, int count);
+        Ast ast;                // the body of the procedure being parsed
+        void LowerProcedure(const string& procName, const NodeList& body);
+        void LowerStatement(NodeIndex s);
+        string LowerExpr(NodeIndex e);
+        void LowerCondition(NodeIndex e, const string& label, bool whenTrue = false);
+        void LowerWhile(NodeIndex w);
+        // a variable a loop steps once a pass by i := i + step, and the lines
+        // that step the products reduced on it
+        struct Induction {
+            const TableEntry* entry;
+            NodeIndex increment;
+            int step;
+            vector<string> steps;
+        };
+        void OptimizeLoop(NodeIndex w, vector<Induction>& inductions, vector<NodeIndex>& worked);
+        // expressions the loops being lowered have worked out ahead of their
+        // bodies, and the operand holding each
+        unordered_map<NodeIndex, string> loopValues;
+        string NewLabel();
+        string loweringName;        // the procedure being lowered
+        int labelCounter = 0;
+        vector<NodeIndex> spine;    // left operand chains LowerExpr is part way down
+        string OperandReference(const TableEntry* entry);
         void GenerateAssembly();
         void WriteAsmHeader(ofstream& asmOutput);
         void WriteDataSection(ofstream& asmOutput);
@@ -89,15 +176,49 @@ class RecursiveDescentParser {
         void ParseTacLine(const string& line, ofstream& asmOutput);
         void HandleAssignment(const string& line, ofstream& asmOutput);
         string InsertStringLiteral(string literal);
+        void MarkOut(const TableEntry* entry);
+        string OutPrefix(const TableEntry* entry);
+
+        // The procedures declared directly in the outer one are compiled by
+        // workers, one each, when a pre-scan of the tokens shows they can be;
+        // see ScanSkeleton and CompileSiblings.
+        struct SiblingRange {
+            size_t first;       // its procedure token
+            size_t last;        // just past its closing semicolon
+            int modeBefore;     // currentMode when the serial parser reaches it
+        };
+        vector<SiblingRange> siblings;  // empty unless planned
+        int modeAfterSiblings = 0;
+        bool ScanSkeleton();
+        size_t SkipProcedure(size_t i, vector<Atom>& nested);
+        bool CompileSiblings();
+        void DeclareSiblings(const vector<SiblingRange>& ranges);
+        void CompileSibling(const SiblingRange& range);
+        void Stitch(RecursiveDescentParser& worker, const TableEntry& heading);
+        void Adopt(const TableEntry& procedure, int sizeOfLocal);
+
+        // what a worker leaves for its parent to stitch in
+        struct TacFixup {
+            size_t offset;      // start of the line in tac
+            Atom argument;      // push of an outer variable: "@" once passed out before
+            string literal;     // or, when argument is noAtom, wrs of this literal
+        };
+        RecursiveDescentParser* parent = nullptr;   // set in a worker
+        Atom predeclared = noAtom;  // a worker's procedure, declared by its parent already
+        string tac;                 // a worker's code, a line at a time
+        vector<TacFixup> fixups;
+        vector<Atom> markedOut;     // outer variables a worker passed as a first argument
         string ResolveAddress(const string& var);
         string FormatOffset(const string& var);
         bool isNumber(const string& s);
         string trim(const string& s);
         vector<pair<string, string>> stringLiterals;
-        vector<string> globalVars;
-        vector<string> globalTemps;
+        vector<Atom> globalVars;
+        vector<Atom> globalTemps;
+        vector<TableEntry*> imported;  // procedures loaded from interface files
         int size(Symbol type);
         string name;
+        string outputBase;      // output file names without .tac/.asm
         bool error = false;
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,131 @@
+/*
+ * SourceBuffer.cpp
+ *
+ * CSC 446 - Compiler Construction - Source Buffer Implementation
+ *
+ * Author: Landon Dahmen
+ *
+ * Description:
+ *   This file implements the SourceBuffer class declared in SourceBuffer.h.
+ *   The file is mapped with mmap and advised for sequential access. Empty
+ *   files and files that refuse to be mapped (pipes, some special files) are
+ *   read into memory with a single bulk read instead.
+ */
+#include <fstream>
+#include <iterator>
+#include <cerrno>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "SourceBuffer.h"
+
+using namespace std;
+
+SourceBuffer::SourceBuffer()
+    : data(""), size(0), mapped(false), stream(-1), base(0), linesBefore(0), lineStartBefore(0)
+{
+}
+
+SourceBuffer::~SourceBuffer()
+{
+    Close();
+}
+
+bool SourceBuffer::Open(const string& name)
+{
+    Close();
+
+    int fd = open(name.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        void* region = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (region != MAP_FAILED) {
+            madvise(region, info.st_size, MADV_SEQUENTIAL);
+            data = static_cast<const char*>(region);
+            size = info.st_size;
+            mapped = true;
+            close(fd);
+            return true;
+        }
+    }
+    close(fd);
+
+    // could not map it, read the whole thing instead
+    ifstream in(name, ios::binary);
+    if (!in) {
+        return false;
+    }
+    owned.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+    data = owned.data();
+    size = owned.size();
+    return true;
+}
+
+void SourceBuffer::OpenStream(int fd, size_t capacity)
+{
+    Close();
+    stream = fd;
+    owned.resize(capacity);
+    data = owned.data();
+}
+
+size_t SourceBuffer::Refill(size_t keep)
+{
+    if (!Streaming()) {
+        return 0;
+    }
+    if (keep > 0) {
+        // remember enough about the dropped bytes to give line numbers later
+        for (size_t i = 0; i < keep; i++) {
+            if (data[i] == '\n') {
+                linesBefore++;
+                lineStartBefore = base + i + 1;
+            }
+        }
+        memmove(&owned[0], data + keep, size - keep);
+        size -= keep;
+        base += keep;
+    }
+    if (size == owned.size()) {
+        // everything in the window is still needed; only then may it grow
+        owned.resize(owned.size() * 2);
+        data = owned.data();
+    }
+    ssize_t count;
+    do {
+        count = read(stream, &owned[size], owned.size() - size);
+    } while (count < 0 && errno == EINTR);
+    if (count <= 0) {
+        return 0;
+    }
+    size += count;
+    return count;
+}
+
+void SourceBuffer::Borrow(const char* text, size_t length)
+{
+    Close();
+    data = text;
+    size = length;
+}
+
+void SourceBuffer::Close()
+{
+    if (mapped) {
+        munmap(const_cast<char*>(data), size);
+        mapped = false;
+    }
+    owned.clear();
+    data = "";
+    size = 0;
+    stream = -1;
+    base = 0;
+    linesBefore = 0;
+    lineStartBefore = 0;
+}
@@ -0,0 +1,64 @@
+/*
+ * SourceBuffer.h
+ *
+ * CSC 446 - Compiler Construction - Source Buffer Header
+ *
+ * Author: Landon Dahmen
+ *
+ * Description:
+ *   This header file declares the SourceBuffer class, which gives the lexical
+ *   analyzer the whole source file as one contiguous, read-only block of
+ *   characters. Regular files are memory-mapped so no copy of the text is
+ *   made; anything that cannot be mapped is read into an owned string instead.
+ *   Lexemes are handed out as views into this block, so the buffer must stay
+ *   alive for as long as those views are in use.
+ *
+ *   A pipe (or stdin) is read through a fixed-size window instead. Refill
+ *   drops the bytes the lexer no longer needs from the front of the window
+ *   and reads more behind what is left, so Data() then starts Base() bytes
+ *   into the input. The window only grows when what must be kept fills it.
+ */
+#ifndef _SOURCEBUFFER_H
+#define _SOURCEBUFFER_H
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+using namespace std;
+
+const size_t streamBufferSize = 64 * 1024;
+
+class SourceBuffer {
+    public:
+        SourceBuffer();
+        ~SourceBuffer();
+
+        bool Open(const string& name);
+        void OpenStream(int fd, size_t capacity = streamBufferSize);
+        void Borrow(const char* text, size_t length);   // caller keeps text alive
+        void Close();
+
+        const char* Data() const { return data; }
+        size_t Size() const { return size; }
+
+        // streams only: drop Data()[0, keep) and read more; returns bytes read
+        size_t Refill(size_t keep);
+        bool Streaming() const { return stream >= 0; }
+        size_t Base() const { return base; }
+        uint32_t LinesBefore() const { return linesBefore; }
+        size_t LineStartBefore() const { return lineStartBefore; }
+
+    private:
+        SourceBuffer(const SourceBuffer&) = delete;
+        SourceBuffer& operator=(const SourceBuffer&) = delete;
+
+        const char* data;
+        size_t size;
+        bool mapped;        // true if data points at an mmap'ed region
+        string owned;       // fallback storage when the file cannot be mapped
+        int stream;         // file descriptor read by Refill, or -1
+        size_t base;        // offset in the input of data[0]
+        uint32_t linesBefore;       // newlines in the bytes dropped so far
+        size_t lineStartBefore;     // offset of the line the window starts in
+};
+#endif
@@ -0,0 +1,71 @@
+/*
+ * SpscRing.h
+ *
+ * CSC 446 - Compiler Construction - Single Producer / Single Consumer Ring
+ *
+ * Author: Landon Dahmen
+ *
+ * Description:
+ *   This header file defines SpscRing, a bounded lock-free queue for exactly
+ *   one producer thread and one consumer thread. The producer only writes
+ *   tail and the consumer only writes head, each on its own cache line; each
+ *   side keeps a cached copy of the other's index and only reloads it when
+ *   the ring looks full (or empty), so in the steady state neither side
+ *   touches the other's line. Try* never block; the caller decides whether
+ *   to spin, yield or give up.
+ */
+#ifndef _SPSCRING_H
+#define _SPSCRING_H
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+template <typename T>
+class SpscRing {
+    public:
+        // capacity must be a power of two
+        explicit SpscRing(size_t capacity) : slots(capacity), mask(capacity - 1) {}
+
+        bool TryPush(T&& item)
+        {
+            size_t at = tail.load(memory_order_relaxed);
+            if (at - headCache == slots.size()) {
+                headCache = head.load(memory_order_acquire);
+                if (at - headCache == slots.size()) {
+                    return false;
+                }
+            }
+            slots[at & mask] = move(item);
+            tail.store(at + 1, memory_order_release);
+            return true;
+        }
+
+        bool TryPop(T& item)
+        {
+            size_t at = head.load(memory_order_relaxed);
+            if (at == tailCache) {
+                tailCache = tail.load(memory_order_acquire);
+                if (at == tailCache) {
+                    return false;
+                }
+            }
+            item = move(slots[at & mask]);
+            head.store(at + 1, memory_order_release);
+            return true;
+        }
+
+    private:
+        SpscRing(const SpscRing&) = delete;
+        SpscRing& operator=(const SpscRing&) = delete;
+
+        vector<T> slots;
+        size_t mask;
+        alignas(64) atomic<size_t> head{0};     // next slot to pop; written by the consumer
+        size_t tailCache = 0;                   // consumer's last look at tail
+        alignas(64) atomic<size_t> tail{0};     // next slot to push; written by the producer
+        size_t headCache = 0;                   // producer's last look at head
+};
+#endif
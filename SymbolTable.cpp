@@ -11,84 +11,262 @@
  *   This file implements the symbol table module declared in SymbolTable.h.
  *   It includes functions for inserting records into the table, looking up
  *   identifiers, deleting records based on scope depth, and printing the table.
- *   The module uses a linked hash table with chaining to handle collisions.
+ *   The module uses an open addressing hash table with linear probing.
+ *   ScopeSnapshot uses the same hash and probing over a table built once.
  */
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <iomanip>
 #include "SymbolTable.h"
 
 using namespace std;
 
-SymbolTable::SymbolTable()
+static size_t HashAtom(Atom atom, int bits)
+{
+    // the top bits of a multiply by 2^32 / golden ratio, which spreads
+    // consecutive atoms
+    return static_cast<uint32_t>(atom * 2654435769u) >> (32 - bits);
+}
+
+SymbolTable::SymbolTable() : ownAtoms(new InternTable), atoms(*ownAtoms),
+    SymTab(size_t(1) << InitialTableBits), slotBits(InitialTableBits)
+{
+}
+
+SymbolTable::SymbolTable(InternTable& atoms) : atoms(atoms),
+    SymTab(size_t(1) << InitialTableBits), slotBits(InitialTableBits)
+{
+}
+
+SymbolTable::SymbolTable(InternTable& atoms, shared_ptr<const ScopeSnapshot> outer)
+    : atoms(atoms), outer(move(outer)),
+    SymTab(size_t(1) << InitialTableBits), slotBits(InitialTableBits)
 {
-    //
-    for (int i = 0; i < TableSize; i++) {
-        SymTab[i] = nullptr;
-    }
 }
 
 SymbolTable::~SymbolTable()
 {
+    // the arenas free every entry and parameter node
 }
 
-void SymbolTable::Insert(string lex, Symbol token, int depth)
+TableEntry* SymbolTable::Insert(Atom atom, Symbol token, int depth, EntryType type)
 {
     // insert the lexeme, token and depth into a record in st
-    int x = hash(lex);
-    TableEntry *Entry = new TableEntry;
+    size_t x = FindSlot(atom);
+    if (SymTab[x].head == nullptr) {
+        // a new name; make room first if it would take an empty slot
+        if (!SymTab[x].tombstone && (used + 1) * 4 > SymTab.size() * 3) {
+            Grow((names + 1) * 2 > SymTab.size() ? SymTab.size() * 2 : SymTab.size());
+            x = FindSlot(atom);
+        }
+        if (!SymTab[x].tombstone) {
+            used++;
+        }
+        SymTab[x].tombstone = false;
+        SymTab[x].atom = atom;
+        names++;
+    }
+
+    Scope* scope = type == functionEntry ? nullptr : &ScopeAt(depth);
+    Arena* arena = scope != nullptr && scope == &scopes.back() ? &scopeArena : &permanentArena;
+    TableEntry *Entry = arena->New<TableEntry>();
 
     Entry->token = token;
-    Entry->lexeme = lex;
+    Entry->lexeme = atoms.Name(atom);
     Entry->depth = depth;
-    Entry->next = SymTab[x];
-    SymTab[x] = Entry;
+    Entry->TypeOfEntry = type;
+    Entry->atom = atom;
+    Entry->next = SymTab[x].head;   // hides any outer declaration
+    SymTab[x].head = Entry;
+
+    TableEntry** list = scope != nullptr ? &scope->entries : &procedures;
+    Entry->nextInScope = *list;
+    *list = Entry;
+
+    if (stats != nullptr) {
+        stats->inserts++;
+        stats->peakNames = max(stats->peakNames, names);
+        if (stats->live.size() <= static_cast<size_t>(depth)) {
+            stats->live.resize(depth + 1);
+            stats->peakLive.resize(depth + 1);
+        }
+        size_t live = ++stats->live[depth];
+        stats->peakLive[depth] = max(stats->peakLive[depth], live);
+    }
+    return Entry;
 }
 
-TableEntry *SymbolTable::Lookup(string lex)
+TableEntry* SymbolTable::Insert(string_view lex, Symbol token, int depth, EntryType type)
 {
-    // lookup uses the lexeme to find the entry and returns a pointer to that entry
-    int index = hash(lex);              // Compute hash index
-    TableEntry* Entry = SymTab[index];  // Get the first entry in the bucket
+    return Insert(atoms.Intern(lex), token, depth, type);
+}
 
-    while (Entry != nullptr) {
-        if (Entry->lexeme == lex) {
-            return Entry;               // Found the entry, return pointer
+const TableEntry *SymbolTable::Lookup(Atom atom) const
+{
+    // lookup uses the atom to find the entry and returns a pointer to the
+    // innermost declaration (nullptr from an empty slot or a tombstone)
+    const TableEntry* Entry = SymTab[FindSlot(atom)].head;
+    if (Entry == nullptr && outer != nullptr) {
+        // shared with other overlays, which is why what Lookup finds is const
+        Entry = outer->Find(atom);
+    }
+    if (stats != nullptr) {
+        stats->lookups++;
+        stats->hits += Entry != nullptr;
+    }
+    return Entry;
+}
+
+const TableEntry *SymbolTable::Lookup(string_view lex) const
+{
+    Atom atom = atoms.Find(lex);
+    if (atom == noAtom) {
+        if (stats != nullptr) {
+            stats->lookups++;   // a miss without a probe: the name was never seen
         }
-        Entry = Entry->next;
+        return nullptr;
     }
+    return Lookup(atom);
+}
 
-    return nullptr;
+TableEntry *SymbolTable::Modify(Atom atom)
+{
+    // never the snapshot's: its entries are shared with other overlays
+    return SymTab[FindSlot(atom)].head;
 }
 
-void SymbolTable::DeleteDepth(int depth)
+size_t SymbolTable::FindSlot(Atom atom) const
 {
-    // delete is passed the depth and deletes all entries at that depth
-    for (int i = 0; i < TableSize; i++) {
-        TableEntry* Entry = SymTab[i];
-        TableEntry* Prev = nullptr;
-
-        while (Entry != nullptr) {
-            if (Entry->depth == depth && Entry->TypeOfEntry != functionEntry) {
-                // Assignment 8 
-                // Remove the entry
-                TableEntry* toDelete = Entry;
-                Entry = Entry->next; // Move to the next before deleting
-               
-                if (Prev == nullptr) {
-                    // If deleting the first node in the list
-                    SymTab[i] = Entry;
-                } else {
-                    Prev->next = Entry;
+    // linear probing; an insert may reuse the first tombstone passed
+    size_t mask = SymTab.size() - 1;
+    size_t reuse = SIZE_MAX;
+    for (size_t i = hash(atom), probes = 1;; i = (i + 1) & mask, probes++) {
+        const Slot& slot = SymTab[i];
+        if (slot.head == nullptr) {
+            if (!slot.tombstone) {
+                if (stats != nullptr) {
+                    CountProbes(probes);
                 }
+                return reuse != SIZE_MAX ? reuse : i;
+            }
+            if (reuse == SIZE_MAX) {
+                reuse = i;
+            }
+        } else if (slot.atom == atom) {
+            if (stats != nullptr) {
+                CountProbes(probes);
+            }
+            return i;
+        }
+    }
+}
 
-                delete toDelete; // Free memory
-            } else {
-                // Move to the next entry
-                Prev = Entry;
-                Entry = Entry->next;
+void SymbolTable::CountProbes(size_t probes) const
+{
+    stats->finds++;
+    stats->probes += probes;
+    stats->longestProbe = max<uint64_t>(stats->longestProbe, probes);
+    int bucket = probes <= 4 ? probes - 1 : probes <= 8 ? 4 : probes <= 16 ? 5 : 6;
+    stats->probeHistogram[bucket]++;
+}
+
+void SymbolTable::Grow(size_t capacity)
+{
+    // rehash, dropping the tombstones
+    if (stats != nullptr) {
+        stats->grows++;
+    }
+    vector<Slot> old(capacity);
+    old.swap(SymTab);
+    while ((size_t(1) << slotBits) < capacity) {
+        slotBits++;
+    }
+    size_t mask = capacity - 1;
+    for (const Slot& slot : old) {
+        if (slot.head != nullptr) {
+            size_t i = hash(slot.atom);
+            while (SymTab[i].head != nullptr) {
+                i = (i + 1) & mask;
             }
+            SymTab[i] = slot;
         }
     }
+    used = names;
+}
+
+SymbolTable::Scope& SymbolTable::ScopeAt(int depth)
+{
+    size_t i = scopes.size();
+    while (i > 0 && scopes[i - 1].depth > depth) {
+        i--;
+    }
+    if (i > 0 && scopes[i - 1].depth == depth) {
+        return scopes[i - 1];
+    }
+    // a scope opened beneath an inner one has only permanent entries until
+    // the inner one closes; its own then start where the inner one's did
+    Arena::Mark mark = i < scopes.size() ? scopes[i].mark : scopeArena.Top();
+    return *scopes.insert(scopes.begin() + i, Scope{depth, mark, nullptr});
+}
+
+void SymbolTable::Unlink(TableEntry* entry)
+{
+    Slot& slot = SymTab[FindSlot(entry->atom)];
+    TableEntry** link = &slot.head;
+    while (*link != entry) {
+        link = &(*link)->next;
+    }
+    *link = entry->next;
+    if (slot.head == nullptr) {
+        slot.tombstone = true;
+        names--;
+    }
+}
+
+void SymbolTable::DeleteDepth(int depth)
+{
+    // delete is passed the depth and deletes all entries at that depth
+    if (stats == nullptr) {
+        DeleteScope(depth);
+        return;
+    }
+    auto start = chrono::steady_clock::now();
+    DeleteScope(depth);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    stats->deletes++;
+    stats->deleteSeconds += seconds;
+    stats->longestDelete = max(stats->longestDelete, seconds);
+}
+
+void SymbolTable::DeleteScope(int depth)
+{
+    size_t i = scopes.size();
+    while (i > 0 && scopes[i - 1].depth != depth) {
+        i--;
+    }
+    if (i == 0) {
+        return;     // nothing was inserted at this depth, or only procedures
+    }
+    Scope& scope = scopes[i - 1];
+    size_t removed = 0;
+    for (TableEntry* Entry = scope.entries; Entry != nullptr; Entry = Entry->nextInScope) {
+        Unlink(Entry);
+        removed++;
+    }
+    if (stats != nullptr && static_cast<size_t>(depth) < stats->live.size()) {
+        // entries inserted before the stats were enabled were never counted
+        stats->live[depth] -= min(removed, stats->live[depth]);
+    }
+
+    if (i == scopes.size()) {
+        // nothing left in the table points past the mark, release it all at once
+        scopeArena.Reset(scope.mark);
+    } else {
+        // released with the next scope in instead
+        scopes[i].mark = scope.mark;
+    }
+    scopes.erase(scopes.begin() + (i - 1));
 }
 
 void SymbolTable::WriteTable(int depth)
@@ -102,88 +280,228 @@ void SymbolTable::WriteTable(int depth)
          << setw(15) << "Offset"
          << setw(20) << "Value/Params" << "\033[0m" << endl;
    
+    // the open scope at this depth, then any procedures declared at it
+    vector<TableEntry*> entries;
+    for (const Scope& scope : scopes) {
+        if (scope.depth == depth) {
+            for (TableEntry* Entry = scope.entries; Entry != nullptr; Entry = Entry->nextInScope) {
+                entries.push_back(Entry);
+            }
+        }
+    }
+    for (TableEntry* Entry = procedures; Entry != nullptr; Entry = Entry->nextInScope) {
+        if (Entry->depth == depth) {
+            entries.push_back(Entry);
+        }
+    }
+    vector<pair<size_t, TableEntry*>> rows;
+    for (TableEntry* Entry : entries) {
+        rows.emplace_back(FindSlot(Entry->atom), Entry);
+    }
+    stable_sort(rows.begin(), rows.end(),
+                [](const auto& a, const auto& b) { return a.first < b.first; });
+
     int count = 0;
-    for (int i = 0; i < TableSize; i++) {
-        TableEntry *Entry = SymTab[i];
-        while (Entry != nullptr) {
-            if (Entry->depth == depth) {
-                count++;
-                // Print index and lexeme
-                cout << left << setw(15) << "[" + to_string(i) + "]"
-                     << setw(20) << Entry->lexeme;
+    for (const auto& [i, Entry] : rows) {
+        count++;
+        // Print index and lexeme
+        cout << left << setw(15) << "[" + to_string(i) + "]"
+             << setw(20) << Entry->lexeme;
+
+        // Print type and other fields based on entry type
+        switch(Entry->TypeOfEntry) {
+            case constEntry:
+                cout << setw(15) << "Constant";
                
-                // Print type and other fields based on entry type
-                switch(Entry->TypeOfEntry) {
-                    case constEntry:
-                        cout << setw(15) << "Constant";
-                       
-                        if (Entry->constant.TypeOfConstant == intType) {
-                            cout << setw(15) << "IntType"
-                                 << setw(15) << "2"
-                                 << setw(15) << Entry->constant.Offset
-                                 << setw(20) << Entry->constant.Value;
-                        } else if (Entry->constant.TypeOfConstant == floatType) {
-                            cout << setw(15) << "FloatType"
-                                 << setw(15) << "4"
-                                 << setw(15) << Entry->constant.Offset
-                                 << setw(20) << Entry->constant.ValueR;
-                        }
-                        break;
-                       
-                    case varEntry:
-                        cout << setw(15) << "Variable";
-                       
-                        if (Entry->var.TypeOfVariable == intType) {
-                            cout << setw(15) << "IntType";
-                        } else if (Entry->var.TypeOfVariable == floatType) {
-                            cout << setw(15) << "FloatType";
-                        } else if (Entry->var.TypeOfVariable == charType) {
-                            cout << setw(15) << "CharType";
-                        }
-                       
-                        cout << setw(15) << Entry->var.size
-                             << setw(15) << Entry->var.Offset;
-                        break;
-                       
-                    case functionEntry:
-                        cout << setw(15) << "Procedure"
-                             << setw(15) << "-"  // No data type for procedures
-                             << setw(15) << Entry->function.SizeOfLocal
-                             << setw(15) << "-"  // No offset for procedures
-                             << setw(20) << "Params: " + to_string(Entry->function.NumberOfParameters);
-                        break;
+                if (Entry->constant.TypeOfConstant == intType) {
+                    cout << setw(15) << "IntType"
+                         << setw(15) << "2"
+                         << setw(15) << Entry->constant.Offset
+                         << setw(20) << Entry->constant.Value;
+                } else if (Entry->constant.TypeOfConstant == floatType) {
+                    cout << setw(15) << "FloatType"
+                         << setw(15) << "4"
+                         << setw(15) << Entry->constant.Offset
+                         << setw(20) << Entry->constant.ValueR;
                 }
-                cout << endl;
-            }
-            Entry = Entry->next;
+                break;
+               
+            case varEntry:
+                cout << setw(15) << "Variable";
+               
+                if (Entry->var.TypeOfVariable == intType) {
+                    cout << setw(15) << "IntType";
+                } else if (Entry->var.TypeOfVariable == floatType) {
+                    cout << setw(15) << "FloatType";
+                } else if (Entry->var.TypeOfVariable == charType) {
+                    cout << setw(15) << "CharType";
+                }
+               
+                cout << setw(15) << Entry->var.size
+                     << setw(15) << Entry->var.Offset;
+                break;
+               
+            case functionEntry:
+                cout << setw(15) << "Procedure"
+                     << setw(15) << "-"  // No data type for procedures
+                     << setw(15) << Entry->function.SizeOfLocal
+                     << setw(15) << "-"  // No offset for procedures
+                     << setw(20) << "Params: " + to_string(Entry->function.NumberOfParameters);
+                break;
         }
+        cout << endl;
     }
     if (count == 0) {
         cout << "No entries at this depth" << endl;
     }
 }
 
-int SymbolTable::GetLocalSize(string procName)
+int SymbolTable::GetLocalSize(string_view procName) const
 {
-    TableEntry* entry = Lookup(procName);
+    const TableEntry* entry = Lookup(procName);
     if (entry && entry->TypeOfEntry == functionEntry) {
         return entry->function.SizeOfLocal;
     }
     return 0;
 }
 
-int  SymbolTable::hash(string lexeme)
+ParamNode* SymbolTable::AddParam(TableEntry* function, VarType type, ParamMode mode)
 {
-    // passed a lexeme and return the location for that lexeme.
-    unsigned int h = 0;
-    unsigned int g = 0;
+    ParamNode* node = permanentArena.New<ParamNode>();
+    node->typeOfParameter = type;
+    node->mode = mode;
+    node->next = nullptr;
+    function->function.NumberOfParameters++;
+    ParamNode** link = &function->function.ParamList;
+    while (*link != nullptr) {
+        link = &(*link)->next;
+    }
+    *link = node;
+    return node;
+}
 
-    for(char c : lexeme) {
-        h = (h << 4) + c;
-        if (g = h&0xf0000000) {
-            h = h ^ (g >> 24);
-            h = h ^ g;
+shared_ptr<const ScopeSnapshot> SymbolTable::Snapshot() const
+{
+    // the innermost declaration of each name, this table's hiding the outer
+    // snapshot's
+    vector<const TableEntry*> visible;
+    for (const Slot& slot : SymTab) {
+        if (slot.head != nullptr) {
+            visible.push_back(slot.head);
         }
     }
-    return h % TableSize;
+    if (outer != nullptr) {
+        for (const ScopeSnapshot::Slot& slot : outer->slots) {
+            if (slot.entry != nullptr && SymTab[FindSlot(slot.atom)].head == nullptr) {
+                visible.push_back(slot.entry);
+            }
+        }
+    }
+
+    shared_ptr<ScopeSnapshot> snapshot(new ScopeSnapshot);
+    int bits = 4;
+    while ((size_t(1) << bits) < visible.size() * 2) {
+        bits++;
+    }
+    snapshot->slotBits = bits;
+    snapshot->slots.resize(size_t(1) << bits);
+    snapshot->count = visible.size();
+    size_t mask = snapshot->slots.size() - 1;
+    for (const TableEntry* Entry : visible) {
+        TableEntry* copy = snapshot->arena.New<TableEntry>();
+        *copy = *Entry;
+        copy->next = nullptr;
+        copy->nextInScope = nullptr;
+        if (Entry->TypeOfEntry == functionEntry) {
+            ParamNode** link = &copy->function.ParamList;
+            for (const ParamNode* param = Entry->function.ParamList; param != nullptr; param = param->next) {
+                ParamNode* node = snapshot->arena.New<ParamNode>();
+                *node = *param;
+                node->next = nullptr;
+                *link = node;
+                link = &node->next;
+            }
+        }
+        size_t i = HashAtom(Entry->atom, bits);
+        while (snapshot->slots[i].entry != nullptr) {
+            i = (i + 1) & mask;
+        }
+        snapshot->slots[i].atom = Entry->atom;
+        snapshot->slots[i].entry = copy;
+    }
+    return snapshot;
+}
+
+const TableEntry* ScopeSnapshot::Find(Atom atom) const
+{
+    // never written after Snapshot, so safe to read from any thread
+    size_t mask = slots.size() - 1;
+    for (size_t i = HashAtom(atom, slotBits);; i = (i + 1) & mask) {
+        if (slots[i].entry == nullptr) {
+            return nullptr;
+        }
+        if (slots[i].atom == atom) {
+            return slots[i].entry;
+        }
+    }
+}
+
+void SymbolTable::EnableStats()
+{
+    if (stats == nullptr) {
+        stats.reset(new SymbolTableStats);
+    }
+}
+
+void SymbolTable::WriteStats(ostream& out) const
+{
+    if (stats == nullptr) {
+        return;
+    }
+    static const char* probeLabels[ProbeBuckets] = {"1", "2", "3", "4", "5-8", "9-16", "17+"};
+    size_t tombstones = used - names;
+
+    out << "\033[1;4m" << "Symbol Table Statistics:" << "\033[0m" << endl;
+    out << left << setw(20) << "Inserts" << stats->inserts << endl;
+    out << setw(20) << "Lookups" << stats->lookups << " (" << stats->hits << " hits, "
+        << stats->lookups - stats->hits << " misses)" << endl;
+    out << setw(20) << "Probe length" << fixed << setprecision(2)
+        << (stats->finds > 0 ? double(stats->probes) / stats->finds : 0.0) << " average, "
+        << stats->longestProbe << " longest, over " << stats->finds << " searches" << endl;
+    out << setw(20) << "Probe histogram";
+    for (int b = 0; b < ProbeBuckets; b++) {
+        out << probeLabels[b] << ": " << stats->probeHistogram[b] << (b + 1 < ProbeBuckets ? "  " : "");
+    }
+    out << endl;
+    out << setw(20) << "Slots" << SymTab.size() << " (" << names << " names, " << tombstones
+        << " tombstones, " << SymTab.size() - used << " empty; peak " << stats->peakNames
+        << " names, grown " << stats->grows << " times)" << endl;
+    out << setw(20) << "Peak live entries";
+    for (size_t d = 0; d < stats->peakLive.size(); d++) {
+        out << (d > 0 ? ", " : "") << "depth " << d << ": " << stats->peakLive[d];
+    }
+    out << endl;
+    out << setw(20) << "DeleteDepth" << stats->deletes << " calls, " << setprecision(3)
+        << stats->deleteSeconds * 1000 << " ms total, " << stats->longestDelete * 1000
+        << " ms longest" << endl;
+    out.unsetf(ios::floatfield | ios::adjustfield);
+    out << setprecision(6);
+}
+
+vector<TableEntry*> SymbolTable::Procedures(int depth) const
+{
+    vector<TableEntry*> found;
+    for (TableEntry* Entry = procedures; Entry != nullptr; Entry = Entry->nextInScope) {
+        if (Entry->depth == depth) {
+            found.push_back(Entry);
+        }
+    }
+    reverse(found.begin(), found.end());
+    return found;
+}
+
+size_t SymbolTable::hash(Atom atom) const
+{
+    // passed an atom and return the location for that atom
+    return HashAtom(atom, slotBits);
 }
\ No newline at end of file
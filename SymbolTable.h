@@ -9,29 +9,72 @@
  *
  * Description:
  *   This header file declares the data structures and function prototypes
- *   for the symbol table module. The symbol table is implemented as a linked
- *   hash table for storing records of variables, constants, and procedures.
+ *   for the symbol table module. The symbol table is implemented as an open
+ *   addressing hash table for storing records of variables, constants, and
+ *   procedures.
  *   It provides functions to insert new records, lookup identifiers,
  *   delete records by scope depth, and output the table contents for debugging.
+ *
+ *   Entries (and their lexemes and parameter lists) are bump allocated from
+ *   arenas rather than one at a time with new. Each open scope starts at a
+ *   mark in scopeArena, so DeleteDepth gives back a whole procedure's
+ *   entries at once. Procedures outlive their scope, and an entry added to an
+ *   enclosing scope (a string literal placed at depth 1) would be caught by
+ *   that release, so both go to permanentArena, which lasts as long as the
+ *   table.
+ *
+ *   Names are atoms from an InternTable (shared with the lexer), so finding
+ *   one compares integers, not strings, and an entry's lexeme is a view of
+ *   the interned text. The table has one slot per atom, not per declaration.
+ *   A slot holds the atom and its innermost declaration, which links to the
+ *   ones it hides, so Lookup finds the innermost first. Slots are probed
+ *   linearly and the table doubles when three quarters of them are in use; a
+ *   name whose last declaration is deleted leaves a tombstone until then.
+ *
+ *   The open scopes are kept on a stack, each with a list of the entries
+ *   inserted in it, so DeleteDepth and WriteTable only visit the entries of
+ *   the one scope rather than the whole table. Procedures are listed apart
+ *   from the scopes since they are never deleted.
+ *
+ *   Snapshot copies the innermost declaration of every visible name into an
+ *   immutable ScopeSnapshot. A table built over a snapshot is an overlay:
+ *   what is inserted into it stays private, and a name it does not hold is
+ *   looked up in the snapshot. The snapshot owns its copies, so the table it
+ *   was taken from may go on inserting and deleting, and any number of
+ *   overlays on different threads may look names up in it at once without
+ *   locking. Lookup therefore gives const entries; Modify gives only the
+ *   table's own, so an entry found in a snapshot cannot be written.
+ *
+ *   EnableStats starts counting inserts, lookups, probe lengths, live entries
+ *   per depth and the time spent in DeleteDepth, for WriteStats to report.
+ *   The counters are only touched when they have been enabled.
  */
 #ifndef _SymbolTable_H
 #define _SymbolTable_H
+#include <cstdint>
+#include <ostream>
 #include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include "Arena.h"
+#include "InternTable.h"
 #include "LexicalAnalyzer.h"
 #include "Globals.h"
 
-const int TableSize = 211;      
+const int InitialTableBits = 8;     // the table starts with 256 slots
 enum VarType {charType, intType, floatType};
 enum EntryType{constEntry, varEntry, functionEntry};
 enum ParamMode{ none, modeIn, modeOut, modeInOut };
 
 struct ParamNode {
     VarType typeOfParameter;
+    ParamMode mode;
     ParamNode* next;
 };   
 
 struct TableEntry {
-    string lexeme;
+    string_view lexeme;           // the interned name of atom
     Symbol token;
     int depth;
     EntryType TypeOfEntry;        // tag field for the union
@@ -61,23 +104,115 @@ struct TableEntry {
             ParamNode* ParamList; // linked list of parameter types
         } function;
     }; // end of union
-    TableEntry* next;  // ptr to next entry in the list
+    TableEntry* next;  // ptr to the declaration of the same name this one hides
+    TableEntry* nextInScope;    // next entry of the same scope (or next procedure)
+    Atom atom;         // interned lexeme
 };
 
 typedef TableEntry * EntryPtr;    // ptr to actual table entry
 
+const int ProbeBuckets = 7;         // probe lengths 1, 2, 3, 4, 5-8, 9-16, 17+
+
+struct SymbolTableStats {
+    uint64_t inserts = 0;
+    uint64_t lookups = 0;
+    uint64_t hits = 0;
+    uint64_t finds = 0;             // slot searches, by inserts, lookups and deletes
+    uint64_t probes = 0;            // slots examined by those searches
+    uint64_t longestProbe = 0;
+    uint64_t probeHistogram[ProbeBuckets] = {};
+    uint64_t grows = 0;
+    size_t peakNames = 0;
+    uint64_t deletes = 0;           // DeleteDepth calls
+    double deleteSeconds = 0;
+    double longestDelete = 0;
+    vector<size_t> live;            // entries at each depth now
+    vector<size_t> peakLive;        // the most ever live at each depth
+};
+
+class ScopeSnapshot {
+    public:
+        const TableEntry* Find(Atom atom) const;
+        size_t Count() const { return count; }      // names visible in it
+
+    private:
+        friend class SymbolTable;
+        ScopeSnapshot() = default;
+        ScopeSnapshot(const ScopeSnapshot&) = delete;
+        ScopeSnapshot& operator=(const ScopeSnapshot&) = delete;
+
+        struct Slot {
+            Atom atom = noAtom;
+            const TableEntry* entry = nullptr;
+        };
+        Arena arena;                // the copied entries and parameter lists
+        vector<Slot> slots;         // open addressing, probed linearly
+        int slotBits = 0;
+        size_t count = 0;
+};
+
 class SymbolTable {
     public:
-        SymbolTable();
+        SymbolTable();                      // interns names in a table of its own
+        explicit SymbolTable(InternTable& atoms);
+        // an overlay: names not inserted in it are looked up in outer
+        SymbolTable(InternTable& atoms, shared_ptr<const ScopeSnapshot> outer);
         ~SymbolTable();
-        void Insert(string lex, Symbol token, int depth);
-        TableEntry* Lookup(string lex);
+        TableEntry* Insert(Atom atom, Symbol token, int depth, EntryType type = varEntry);
+        TableEntry* Insert(string_view lex, Symbol token, int depth, EntryType type = varEntry);
+        const TableEntry* Lookup(Atom atom) const;
+        const TableEntry* Lookup(string_view lex) const;
+        // the innermost declaration inserted in this table, to change it;
+        // nullptr if there is none, even when the snapshot has the name
+        TableEntry* Modify(Atom atom);
         void DeleteDepth(int depth);
         void WriteTable(int depth);
-        int GetLocalSize(string procName);
+        int GetLocalSize(string_view procName) const;
+        size_t Count() const { return names; }      // distinct names in the table
+        // append a parameter to ParamList and count it in NumberOfParameters
+        ParamNode* AddParam(TableEntry* function, VarType type, ParamMode mode);
+        vector<TableEntry*> Procedures(int depth) const;   // in the order inserted
+        shared_ptr<const ScopeSnapshot> Snapshot() const;  // every name visible now
+        void EnableStats();
+        const SymbolTableStats* Stats() const { return stats.get(); }
+        void WriteStats(ostream& out) const;
 
     private:
-        int hash(string lexeme);
-        TableEntry* SymTab[TableSize];
+        struct Scope {
+            int depth;
+            Arena::Mark mark;       // scopeArena position its entries start at
+            TableEntry* entries;    // newest first, linked by nextInScope
+        };
+
+        struct Slot {
+            TableEntry* head = nullptr;     // innermost declaration of the name
+            Atom atom = noAtom;
+            bool tombstone = false;         // name removed, keep probing past it
+        };
+
+        size_t hash(Atom atom) const;       // the slot probing for atom starts at
+        size_t FindSlot(Atom atom) const;   // slot of atom, or an empty one
+        void Grow(size_t capacity);
+        Scope& ScopeAt(int depth);
+        void Unlink(TableEntry* entry);
+        void DeleteScope(int depth);
+        void CountProbes(size_t probes) const;
+
+        unique_ptr<InternTable> ownAtoms;   // only when not given a table
+        InternTable& atoms;
+        shared_ptr<const ScopeSnapshot> outer;  // null unless an overlay
+        vector<Slot> SymTab;
+        int slotBits;               // SymTab has 1 << slotBits slots
+        size_t names = 0;           // slots holding a name
+        size_t used = 0;            // slots holding a name or a tombstone
+
+        SymbolTable(const SymbolTable&) = delete;
+        SymbolTable& operator=(const SymbolTable&) = delete;
+
+        Arena scopeArena;           // entries of the open scopes, innermost last
+        Arena permanentArena;       // procedures and entries added to an enclosing scope
+        vector<Scope> scopes;       // open scopes by depth, innermost last
+        TableEntry* procedures = nullptr;   // every procedure, newest first
+        unique_ptr<SymbolTableStats> stats; // null unless EnableStats was called
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,80 @@
+/*
+ * TokenPipeline.cpp
+ *
+ * CSC 446 - Compiler Construction - Pipelined Lexer Implementation
+ *
+ * Author: Landon Dahmen
+ *
+ * Description:
+ *   This file implements the TokenPipeline class declared in TokenPipeline.h.
+ */
+#include <iostream>
+#include <sstream>
+#include "TokenPipeline.h"
+#include "Globals.h"
+
+using namespace std;
+
+TokenPipeline::TokenPipeline(LexicalAnalyzer& lex, size_t capacity)
+    : lex(lex), ring(capacity), source(lex.Source().Data()), startCh(ch)
+{
+    producer = thread(&TokenPipeline::Produce, this);
+}
+
+TokenPipeline::~TokenPipeline()
+{
+    stop = true;
+    if (producer.joinable()) {
+        producer.join();
+    }
+}
+
+void TokenPipeline::Produce()
+{
+    // the lexer's current character lives in a per-thread global
+    ch = startCh;
+    ostringstream pending;
+    lex.SetDiagnostics(pending);
+    TokenStream one;
+    Symbol token;
+    int reported = lex.Errors();
+    do {
+        one.Clear();
+        lex.ReadToken(one);
+        Record record;
+        record.token = token = one.Kind(0);
+        record.offset = one.Offset(0);
+        record.length = one.Length(0);
+        record.value = one.NumValue(0);
+        if (pending.tellp() > 0) {
+            record.messages.reset(new string(pending.str()));
+            pending.str("");
+        }
+        record.errors = lex.Errors() - reported;
+        reported = lex.Errors();
+        while (!ring.TryPush(move(record))) {
+            if (stop) {
+                return;
+            }
+            this_thread::yield();
+        }
+    } while (token != eoft);
+}
+
+void TokenPipeline::ReadToken(TokenStream& tokens)
+{
+    // past the end the lockstep lexer keeps returning eoft, and so do we
+    if (!finished) {
+        while (!ring.TryPop(last)) {
+            this_thread::yield();
+        }
+        finished = last.token == eoft;
+    }
+    if (last.messages) {
+        cout << *last.messages;
+        last.messages.reset();
+        errors += last.errors;
+    }
+    tokens.SetSource(source);
+    tokens.Append(last.token, last.offset, last.length, last.value);
+}
@@ -0,0 +1,67 @@
+/*
+ * TokenPipeline.h
+ *
+ * CSC 446 - Compiler Construction - Pipelined Lexer Header
+ *
+ * Author: Landon Dahmen
+ *
+ * Description:
+ *   This header file declares the TokenPipeline class, which runs a
+ *   LexicalAnalyzer on its own thread and hands its tokens to the parser
+ *   through an SpscRing, so lexing overlaps with parsing. ReadToken is the
+ *   drop-in replacement for LexicalAnalyzer::ReadToken on the parser side.
+ *
+ *   Lexical errors are not printed by the lexer thread. They travel in the
+ *   ring with the token that caused them and are printed when the parser
+ *   reads that token, which is exactly when the lockstep lexer would have
+ *   printed them, so the output is the same in both modes. Errors keeps
+ *   their count on the parser side, since the lexer's own is the other
+ *   thread's.
+ *
+ *   The source must stay in memory while the pipeline runs (a mapped file,
+ *   not a stream read through a refill buffer).
+ */
+#ifndef _TOKENPIPELINE_H
+#define _TOKENPIPELINE_H
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include "LexicalAnalyzer.h"
+#include "TokenStream.h"
+#include "SpscRing.h"
+
+using namespace std;
+
+class TokenPipeline {
+    public:
+        TokenPipeline(LexicalAnalyzer& lex, size_t capacity = 4096);
+        ~TokenPipeline();
+
+        // append the next token to tokens, waiting for the lexer if needed
+        void ReadToken(TokenStream& tokens);
+        int Errors() const { return errors; }      // lexical errors of the tokens read
+
+    private:
+        struct Record {
+            Symbol token;
+            uint32_t offset;
+            uint32_t length;
+            TokenValue value;
+            unique_ptr<string> messages;    // lexical errors for this token, if any
+            int errors = 0;                 // how many
+        };
+
+        void Produce();
+
+        LexicalAnalyzer& lex;
+        SpscRing<Record> ring;
+        atomic<bool> stop{false};   // set when the parser quits before eoft
+        const char* source = nullptr;
+        char startCh;               // ch of the lexer when the pipeline took it over
+        Record last;                // most recent token handed to the parser
+        bool finished = false;      // true once eoft has been read
+        int errors = 0;
+        thread producer;
+};
+#endif
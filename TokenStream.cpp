@@ -0,0 +1,172 @@
+/*
+ * TokenStream.cpp
+ *
+ * CSC 446 - Compiler Construction - Token Stream Implementation
+ *
+ * Author: Landon Dahmen
+ *
+ * Description:
+ *   This file implements the TokenStream class declared in TokenStream.h.
+ */
+#include <algorithm>
+#include "TokenStream.h"
+#include "Keywords.h"
+#include "LexerTables.h"
+
+using namespace std;
+
+void TokenStream::Reserve(size_t count)
+{
+    count += gapLength;
+    kinds.reserve(count);
+    offsets.reserve(count);
+    lengths.reserve(count);
+    values.reserve(count);
+}
+
+void TokenStream::Clear()
+{
+    kinds.clear();
+    offsets.clear();
+    lengths.clear();
+    values.clear();
+    gapStart = 0;
+    gapLength = 0;
+    offsetShift = 0;
+}
+
+void TokenStream::Append(Symbol token, size_t offset, size_t length, TokenValue value)
+{
+    // the end of the stream is always after the gap
+    kinds.push_back(static_cast<uint8_t>(token));
+    offsets.push_back(static_cast<uint32_t>(offset) - offsetShift);
+    lengths.push_back(static_cast<uint32_t>(length));
+    values.push_back(value);
+}
+
+void TokenStream::AppendFrom(const TokenStream& other, size_t count, size_t offsetDelta)
+{
+    for (size_t i = 0; i < count; i++) {
+        Append(other.Kind(i), other.Offset(i) + offsetDelta, other.Length(i), other.NumValue(i));
+    }
+}
+
+void TokenStream::Splice(size_t first, size_t last, const TokenStream& other, size_t count,
+                         long offsetDelta)
+{
+    MoveGap(first);
+    gapLength += last - first;      // the replaced tokens join the gap
+    if (gapLength < count) {
+        GrowGap(count);
+    }
+    for (size_t i = 0; i < count; i++) {
+        kinds[gapStart] = static_cast<uint8_t>(other.Kind(i));
+        offsets[gapStart] = other.Offset(i);
+        lengths[gapStart] = other.Length(i);
+        values[gapStart] = other.NumValue(i);
+        gapStart++;
+        gapLength--;
+    }
+    offsetShift += static_cast<uint32_t>(offsetDelta);
+}
+
+template <typename T>
+static void MoveColumn(vector<T>& column, size_t from, size_t count, size_t to, T shift)
+{
+    // move count entries that cross the gap, adding shift to each (the gap
+    // and the moved block may overlap, so copy in the safe direction)
+    auto source = column.begin() + from;
+    auto transformed = [shift](T x) { return static_cast<T>(x + shift); };
+    if (to < from) {
+        transform(source, source + count, column.begin() + to, transformed);
+    } else {
+        for (size_t i = count; i-- > 0;) {
+            column[to + i] = transformed(column[from + i]);
+        }
+    }
+}
+
+template <typename T>
+static void MoveColumn(vector<T>& column, size_t from, size_t count, size_t to)
+{
+    if (to < from) {
+        copy(column.begin() + from, column.begin() + from + count, column.begin() + to);
+    } else {
+        copy_backward(column.begin() + from, column.begin() + from + count,
+                      column.begin() + to + count);
+    }
+}
+
+void TokenStream::MoveGap(size_t index)
+{
+    // tokens that cross the gap change between absolute and shifted storage
+    size_t from, to, count;
+    uint32_t offsetBy;
+    if (gapStart < index) {
+        count = index - gapStart;
+        from = gapStart + gapLength;
+        to = gapStart;
+        offsetBy = offsetShift;
+    } else {
+        count = gapStart - index;
+        from = index;
+        to = index + gapLength;
+        offsetBy = -offsetShift;
+    }
+    if (count > 0 && gapLength > 0) {
+        MoveColumn(kinds, from, count, to);
+        MoveColumn(offsets, from, count, to, offsetBy);
+        MoveColumn(lengths, from, count, to);
+        MoveColumn(values, from, count, to);
+    } else if (count > 0) {
+        // no gap to move, only the stored offsets change
+        MoveColumn(offsets, from, count, from, offsetBy);
+    }
+    gapStart = index;
+}
+
+template <typename T>
+static void WidenGap(vector<T>& column, size_t gapEnd, size_t extra)
+{
+    column.insert(column.begin() + gapEnd, extra, T());
+}
+
+void TokenStream::GrowGap(size_t count)
+{
+    // leave room for more edits than this one so the tail rarely moves
+    size_t extra = count - gapLength + 64 + Size() / 64;
+    size_t gapEnd = gapStart + gapLength;
+    WidenGap(kinds, gapEnd, extra);
+    WidenGap(offsets, gapEnd, extra);
+    WidenGap(lengths, gapEnd, extra);
+    WidenGap(values, gapEnd, extra);
+    gapLength += extra;
+}
+
+size_t TokenStream::FirstAtOrAfter(size_t offset) const
+{
+    size_t low = 0, high = Size();
+    while (low < high) {
+        size_t middle = (low + high) / 2;
+        if (Offset(middle) < offset) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+string_view TokenStream::Lexeme(size_t i) const
+{
+    string_view text(source + (Offset(i) - sourceBase), Length(i));
+    Symbol token = Kind(i);
+    if (token != idt && token != unknownt && !text.empty() && ClassOf(text[0]) == ccLetter) {
+        // reserved words read back in the lower case spelling the lexer gave them
+        const Keyword* keyword = FindKeyword(text.data(), text.size());
+        if (keyword != nullptr) {
+            return keyword->lexeme;
+        }
+    }
+    return text;
+}
@@ -0,0 +1,76 @@
+/*
+ * TokenStream.h
+ *
+ * CSC 446 - Compiler Construction - Token Stream Header
+ *
+ * Author: Landon Dahmen
+ *
+ * Description:
+ *   This header file declares the TokenStream class, a struct-of-arrays store
+ *   for lexed tokens: one array each for the token kinds, source offsets,
+ *   lengths and numeric values. The parser reads its tokens through a
+ *   TokenStream by index, which lets it look any number of tokens ahead in
+ *   O(1) once they have been lexed. The text of a token is not copied;
+ *   Lexeme(i) rebuilds the view from the source buffer. Line numbers are not
+ *   kept either; a LineTable turns a token's offset into a line and column
+ *   when a diagnostic needs one.
+ */
+#ifndef _TOKENSTREAM_H
+#define _TOKENSTREAM_H
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "LexicalAnalyzer.h"
+#include "InternTable.h"
+
+using namespace std;
+
+union TokenValue {
+    int Value;          // integer literal
+    double ValueR;      // real literal
+    Atom Ident;         // identifier, when the lexer was given an InternTable
+};
+
+class TokenStream {
+    public:
+        // text is the source from input offset base on (base is only non-zero
+        // for a stream read through a refill buffer)
+        void SetSource(const char* text, size_t base = 0) { source = text; sourceBase = base; }
+        void Reserve(size_t count);
+        void Clear();
+        void Append(Symbol token, size_t offset, size_t length, TokenValue value);
+        // append the first count tokens of other, moving them by offsetDelta
+        void AppendFrom(const TokenStream& other, size_t count, size_t offsetDelta);
+        // replace tokens [first, last) with the first count tokens of other, then
+        // move the tokens after them by offsetDelta
+        void Splice(size_t first, size_t last, const TokenStream& other, size_t count,
+                    long offsetDelta);
+        size_t FirstAtOrAfter(size_t offset) const;     // index of first token at or after offset
+
+        size_t Size() const { return kinds.size() - gapLength; }
+        Symbol Kind(size_t i) const { return static_cast<Symbol>(kinds[Slot(i)]); }
+        uint32_t Offset(size_t i) const { return offsets[Slot(i)] + (i < gapStart ? 0 : offsetShift); }
+        uint32_t Length(size_t i) const { return lengths[Slot(i)]; }
+        TokenValue NumValue(size_t i) const { return values[Slot(i)]; }
+        string_view Lexeme(size_t i) const;
+
+    private:
+        // Splice leaves an unused gap in the arrays where it last worked, and
+        // the offsets of the tokens after the gap are stored relative to
+        // offsetShift. An edit near the previous one only moves the tokens
+        // between the two, not the whole tail of the stream.
+        size_t Slot(size_t i) const { return i < gapStart ? i : i + gapLength; }
+        void MoveGap(size_t index);
+        void GrowGap(size_t count);
+
+        const char* source = "";
+        size_t sourceBase = 0;
+        vector<uint8_t> kinds;
+        vector<uint32_t> offsets;
+        vector<uint32_t> lengths;
+        vector<TokenValue> values;
+        size_t gapStart = 0;        // index of the first token after the gap
+        size_t gapLength = 0;
+        uint32_t offsetShift = 0;   // added to the offsets after the gap
+};
+#endif
@@ -0,0 +1,345 @@
+/*
+ * AsmMachine.h
+ *
+ * CSC 446 - Compiler Construction - Generated Assembly Interpreter
+ *
+ * Author: Landon Dahmen
+ *
+ * Description:
+ *   Runs the .asm the compiler writes, for the benchmarks that measure the
+ *   code rather than the compiler. Only the instructions the code generator
+ *   emits are understood: mov, add, sub, imul, cmp, set<cc>, j<cc>, jmp,
+ *   push and pop of bp, call and ret, and the io.asm routines writestr,
+ *   writeint, writeln and readint (which reads 0). Every instruction executed
+ *   is counted once, a call to io.asm included, and what the program writes
+ *   is kept so two compilations of one program can be checked against each
+ *   other.
+ */
+#ifndef _ASMMACHINE_H
+#define _ASMMACHINE_H
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class AsmMachine {
+    public:
+        // false if the file could not be read or holds an instruction or
+        // operand this machine does not know
+        bool Load(const string& path)
+        {
+            ifstream in(path);
+            if (!in) {
+                return false;
+            }
+            string line;
+            bool code = false;
+            vector<pair<size_t, string>> jumps;     // instruction and target label
+            while (getline(in, line)) {
+                // a ; starts a comment, except in the strings of the data
+                line = Trim(code ? line.substr(0, line.find(';')) : line);
+                if (line.empty()) {
+                    continue;
+                }
+                if (line == ".code") {
+                    code = true;
+                    continue;
+                }
+                if (!code) {
+                    if (!Declare(line) && line[0] != '.') {
+                        return false;
+                    }
+                    continue;
+                }
+                istringstream words(line);
+                string op, rest;
+                words >> op;
+                getline(words, rest);
+                rest = Trim(rest);
+                if (op.back() == ':') {
+                    labels[op.substr(0, op.size() - 1)] = program.size();
+                    continue;
+                }
+                if (rest == "PROC") {
+                    labels[op] = program.size();
+                    continue;
+                }
+                if (rest == "ENDP" || op == "include" || op == "END" || op == "PUBLIC"
+                    || op == "EXTRN") {
+                    continue;
+                }
+                Instruction instruction;
+                instruction.op = op;
+                if (op == "call" || op == "jmp" || (op[0] == 'j' && Condition(op.substr(1)) >= 0)) {
+                    jumps.push_back({program.size(), rest});
+                } else if (!rest.empty()) {
+                    size_t comma = rest.find(',');
+                    if (!Decode(Trim(rest.substr(0, comma)), instruction.a)) {
+                        return false;
+                    }
+                    if (comma != string::npos && !Decode(Trim(rest.substr(comma + 1)), instruction.b)) {
+                        return false;
+                    }
+                }
+                program.push_back(instruction);
+            }
+            for (const auto& [at, label] : jumps) {
+                auto target = labels.find(label);
+                if (target != labels.end()) {
+                    program[at].target = target->second;
+                } else if (label == "writestr" || label == "writeint" || label == "writeln"
+                           || label == "readint") {
+                    program[at].op = label;
+                } else {
+                    return false;
+                }
+            }
+            return labels.count("start") != 0;
+        }
+
+        // run from start until the program exits; false if it ran past limit
+        // instructions or off the end of its code
+        bool Run(long limit = 1000000000)
+        {
+            executed = 0;
+            branches = 0;
+            output.clear();
+            registers[sp] = -2;
+            size_t pc = labels["start"];
+            while (pc < program.size() && executed < limit) {
+                const Instruction& i = program[pc++];
+                executed++;
+                const string& op = i.op;
+                if (op == "mov") {
+                    Write(i.a, Read(i.b));
+                } else if (op == "add") {
+                    Write(i.a, Read(i.a) + Read(i.b));
+                } else if (op == "sub") {
+                    Write(i.a, Read(i.a) - Read(i.b));
+                } else if (op == "imul") {
+                    int32_t product = int32_t(int16_t(registers[ax])) * int16_t(Read(i.a));
+                    registers[ax] = uint16_t(product);
+                    registers[dx] = uint16_t(product >> 16);
+                } else if (op == "cmp") {
+                    compareLeft = int16_t(Read(i.a));
+                    compareRight = int16_t(Read(i.b));
+                } else if (op == "jmp") {
+                    pc = i.target;
+                } else if (op == "call") {
+                    Push(uint16_t(pc));
+                    pc = i.target;
+                } else if (op == "ret") {
+                    pc = Pop();
+                    registers[sp] += Read(i.a);
+                } else if (op == "push") {
+                    Push(Read(i.a));
+                } else if (op == "pop") {
+                    Write(i.a, Pop());
+                } else if (op == "writestr") {
+                    for (uint16_t at = registers[dx]; memory[at] != '$'; at++) {
+                        output += char(memory[at]);
+                    }
+                } else if (op == "writeint") {
+                    output += to_string(int16_t(registers[dx]));
+                } else if (op == "writeln") {
+                    output += '\n';
+                } else if (op == "readint") {
+                    registers[bx] = 0;
+                } else if (op == "int") {
+                    return true;        // int 21h with ah = 4ch, the only one emitted
+                } else if (op[0] == 'j') {
+                    branches++;
+                    if (Holds(Condition(op.substr(1)))) {
+                        pc = i.target;
+                    }
+                } else if (op.compare(0, 3, "set") == 0) {
+                    Write(i.a, Holds(Condition(op.substr(3))));
+                } else {
+                    return false;
+                }
+            }
+            return false;
+        }
+
+        // instructions in the code, not counting labels and directives
+        size_t Size() const { return program.size(); }
+
+        long executed = 0;
+        long branches = 0;      // conditional jumps executed
+        string output;
+
+    private:
+        enum Register { ax, bx, dx, bp, sp, ds, registerCount };
+
+        struct Operand {
+            enum { none, immediate, reg, low, high, memory } kind = none;
+            int value = 0;      // the number, register, or address (from bp if bpRelative)
+            bool bpRelative = false;
+        };
+
+        struct Instruction {
+            string op;
+            Operand a, b;
+            size_t target = 0;
+        };
+
+        static string Trim(const string& s)
+        {
+            size_t first = s.find_first_not_of(" \t\r");
+            if (first == string::npos) {
+                return "";
+            }
+            return s.substr(first, s.find_last_not_of(" \t\r") - first + 1);
+        }
+
+        static int Condition(const string& cc)
+        {
+            static const char* codes[] = {"e", "ne", "l", "le", "g", "ge"};
+            for (int c = 0; c < 6; c++) {
+                if (cc == codes[c]) {
+                    return c;
+                }
+            }
+            return -1;
+        }
+
+        bool Holds(int condition) const
+        {
+            switch (condition) {
+                case 0: return compareLeft == compareRight;
+                case 1: return compareLeft != compareRight;
+                case 2: return compareLeft < compareRight;
+                case 3: return compareLeft <= compareRight;
+                case 4: return compareLeft > compareRight;
+                default: return compareLeft >= compareRight;
+            }
+        }
+
+        // name DW ? or name DB "text","$"
+        bool Declare(const string& line)
+        {
+            istringstream words(line);
+            string name, kind;
+            words >> name >> kind;
+            if (kind == "DW") {
+                symbols[name] = dataEnd;
+                dataEnd += 2;
+                return true;
+            }
+            if (kind == "DB") {
+                symbols[name] = dataEnd;
+                size_t open = line.find('"');
+                size_t close = line.find('"', open + 1);
+                for (size_t c = open + 1; c < close; c++) {
+                    memory[dataEnd++] = uint8_t(line[c]);
+                }
+                memory[dataEnd++] = '$';
+                return true;
+            }
+            return false;
+        }
+
+        bool Decode(const string& text, Operand& operand)
+        {
+            static const char* names[] = {"ax", "bx", "dx", "bp", "sp", "ds"};
+            for (int r = 0; r < registerCount; r++) {
+                if (text == names[r]) {
+                    operand.kind = Operand::reg;
+                    operand.value = r;
+                    return true;
+                }
+            }
+            if (text == "al" || text == "ah") {
+                operand.kind = text == "al" ? Operand::low : Operand::high;
+                return true;
+            }
+            if (text == "@data") {
+                operand.kind = Operand::immediate;
+                return true;
+            }
+            if (text.compare(0, 7, "offset ") == 0) {
+                auto symbol = symbols.find(Trim(text.substr(7)));
+                operand.kind = Operand::immediate;
+                operand.value = symbol == symbols.end() ? 0 : symbol->second;
+                return symbol != symbols.end();
+            }
+            if (text.compare(0, 3, "[bp") == 0) {
+                operand.kind = Operand::memory;
+                operand.bpRelative = true;
+                operand.value = stoi(text.substr(3, text.size() - 4));
+                return true;
+            }
+            if (isdigit(static_cast<unsigned char>(text[0])) || text[0] == '-') {
+                operand.kind = Operand::immediate;
+                operand.value = stoi(text, nullptr, text.back() == 'h' ? 16 : 10);
+                return true;
+            }
+            auto symbol = symbols.find(text);
+            operand.kind = Operand::memory;
+            operand.value = symbol == symbols.end() ? 0 : symbol->second;
+            return symbol != symbols.end();
+        }
+
+        uint16_t Address(const Operand& operand) const
+        {
+            return uint16_t(operand.value + (operand.bpRelative ? registers[bp] : 0));
+        }
+
+        uint16_t Read(const Operand& operand) const
+        {
+            switch (operand.kind) {
+                case Operand::immediate: return uint16_t(operand.value);
+                case Operand::reg: return registers[operand.value];
+                case Operand::low: return registers[ax] & 0xff;
+                case Operand::high: return registers[ax] >> 8;
+                case Operand::memory: {
+                    uint16_t at = Address(operand);
+                    return uint16_t(memory[at] | memory[uint16_t(at + 1)] << 8);
+                }
+                default: return 0;
+            }
+        }
+
+        void Write(const Operand& operand, uint16_t value)
+        {
+            switch (operand.kind) {
+                case Operand::reg: registers[operand.value] = value; break;
+                case Operand::low: registers[ax] = (registers[ax] & 0xff00) | (value & 0xff); break;
+                case Operand::high: registers[ax] = (registers[ax] & 0xff) | uint16_t(value << 8); break;
+                case Operand::memory: {
+                    uint16_t at = Address(operand);
+                    memory[at] = uint8_t(value);
+                    memory[uint16_t(at + 1)] = uint8_t(value >> 8);
+                    break;
+                }
+                default: break;
+            }
+        }
+
+        void Push(uint16_t value)
+        {
+            registers[sp] -= 2;
+            memory[registers[sp]] = uint8_t(value);
+            memory[uint16_t(registers[sp] + 1)] = uint8_t(value >> 8);
+        }
+
+        uint16_t Pop()
+        {
+            uint16_t value = uint16_t(memory[registers[sp]] | memory[uint16_t(registers[sp] + 1)] << 8);
+            registers[sp] += 2;
+            return value;
+        }
+
+        vector<Instruction> program;
+        map<string, size_t> labels;
+        map<string, int> symbols;       // data addresses
+        int dataEnd = 0;
+        vector<uint8_t> memory = vector<uint8_t>(65536);
+        uint16_t registers[registerCount] = {};
+        int16_t compareLeft = 0, compareRight = 0;
+};
+#endif
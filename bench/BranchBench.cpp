@@ -0,0 +1,142 @@
+/*
+ * BranchBench.cpp
+ *
+ * CSC 446 - Compiler Construction - Conditional Branch Benchmark
+ *
+ * Author: Landon Dahmen
+ *
+ * Description:
+ *   Generates a branch-heavy program (an if/elsif chain and several ifs per
+ *   round, repeated by recursion) in two forms and compiles both. In the
+ *   first each condition is a relation, which compiles to a cmp and one
+ *   conditional jump. In the second each relation is compared with 1 (or 0
+ *   under a not), which keeps its value in a temporary first, as every
+ *   condition was compiled before the fused branch. Each .asm is run on
+ *   AsmMachine; the two must write the same output, and the instructions
+ *   in the code, the instructions executed and the conditional jumps
+ *   executed are reported for each.
+ *
+ *   Usage: branch_bench [rounds]
+ */
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include "AsmMachine.h"
+#include "../Parser.h"
+#include "../Globals.h"
+
+using namespace std;
+
+thread_local Symbol Token;
+thread_local string_view Lexeme;
+thread_local char ch;
+thread_local int Value;
+thread_local double ValueR;
+thread_local string Literal;
+
+const int depth = 100;      // rounds per call of step, one stack frame each
+
+// the condition, as a relation or as the relation's value compared with 1
+static string Condition(const string& relation, bool direct)
+{
+    return direct ? relation : "(" + relation + ") = 1";
+}
+
+static string NotCondition(const string& relation, bool direct)
+{
+    return direct ? "not (" + relation + ")" : "(" + relation + ") = 0";
+}
+
+static void WriteSource(const string& path, int rounds, bool direct)
+{
+    ofstream out(path);
+    out << "procedure bench is\n"
+        << "    a, b, n, hits, misses, same: integer;\n"
+        << "    procedure step is\n"
+        << "    begin\n"
+        << "        if " << Condition("n < " + to_string(depth), direct) << " then\n"
+        << "            n := n + 1;\n"
+        << "            a := a + 7;\n"
+        << "            if " << Condition("a > 12", direct) << " then\n"
+        << "                a := a - 13;\n"
+        << "            end if;\n"
+        << "            b := b + 3;\n"
+        << "            if " << Condition("b >= 10", direct) << " then\n"
+        << "                b := b - 10;\n"
+        << "            end if;\n"
+        << "            if " << Condition("a < 3", direct) << " then\n"
+        << "                hits := hits + 1;\n"
+        << "            elsif " << Condition("a = 5", direct) << " then\n"
+        << "                hits := hits + 2;\n"
+        << "            elsif " << Condition("a > b", direct) << " then\n"
+        << "                hits := hits + 3;\n"
+        << "            elsif " << Condition("a <= 8", direct) << " then\n"
+        << "                hits := hits - 1;\n"
+        << "            else\n"
+        << "                misses := misses + 1;\n"
+        << "            end if;\n"
+        << "            if " << NotCondition("a /= b", direct) << " then\n"
+        << "                same := same + 1;\n"
+        << "            end if;\n"
+        << "            step();\n"
+        << "        end if;\n"
+        << "    end step;\n"
+        << "begin\n"
+        << "    a := 0; b := 0; hits := 0; misses := 0; same := 0;\n";
+    for (int r = 0; r < rounds; r += depth) {
+        out << "    n := 0;\n    step();\n";
+    }
+    out << "    putln(hits);\n    putln(misses);\n    putln(same);\n"
+        << "end bench;\n";
+}
+
+static bool CompileAndRun(const string& path, AsmMachine& machine)
+{
+    ostringstream quiet;
+    streambuf* saved = cout.rdbuf(quiet.rdbuf());
+    {
+        RecursiveDescentParser rdp(path);
+    }
+    cout.rdbuf(saved);
+    string base = path.substr(0, path.size() - 4);
+    bool ok = quiet.str().find("completed successfully") != string::npos
+        && machine.Load(base + ".asm") && machine.Run();
+    remove(path.c_str());
+    remove((base + ".tac").c_str());
+    remove((base + ".asm").c_str());
+    return ok;
+}
+
+int main(int argc, char* argv[])
+{
+    int rounds = argc > 1 ? stoi(argv[1]) : 2000;
+    struct Form {
+        const char* name;
+        bool direct;
+        AsmMachine machine;
+    } forms[] = {{"cmp and jump", true, {}}, {"0/1 temporary", false, {}}};
+    cout << rounds << " rounds" << endl;
+    cout << setw(16) << "conditions" << setw(12) << "in code" << setw(12) << "executed"
+         << setw(12) << "jumps" << endl;
+    for (Form& form : forms) {
+        string path = "branch_bench_input.ada";
+        WriteSource(path, rounds, form.direct);
+        if (!CompileAndRun(path, form.machine)) {
+            cout << form.name << ": did not compile and run" << endl;
+            return 1;
+        }
+        cout << setw(16) << form.name << setw(12) << form.machine.Size()
+             << setw(12) << form.machine.executed << setw(12) << form.machine.branches << endl;
+    }
+    if (forms[0].machine.output != forms[1].machine.output) {
+        cout << "the two forms wrote different output" << endl;
+        return 1;
+    }
+    cout << "executed " << fixed << setprecision(1)
+         << 100.0 * forms[0].machine.executed / forms[1].machine.executed
+         << "% of the instructions" << endl;
+    return 0;
+}
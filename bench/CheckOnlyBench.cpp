@@ -0,0 +1,100 @@
+/*
+ * CheckOnlyBench.cpp
+ *
+ * CSC 446 - Compiler Construction - Check Only Benchmark
+ *
+ * Author: Landon Dahmen
+ *
+ * Description:
+ *   Generates a large Ada program and compiles it in full, writing TAC and
+ *   assembly, then only checks it (--check-only), which parses and
+ *   resolves every name but does no lowering and writes no files. Both runs
+ *   must accept the program and the check must leave no output file behind;
+ *   the best time of each is reported.
+ *
+ *   Usage: check_only_bench [procedures] [rounds]
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include "../Parser.h"
+#include "../Globals.h"
+
+using namespace std;
+
+thread_local Symbol Token;
+thread_local string_view Lexeme;
+thread_local char ch;
+thread_local int Value;
+thread_local double ValueR;
+thread_local string Literal;
+
+static void WriteSource(const string& path, int procedures)
+{
+    ofstream out(path);
+    out << "procedure bench is\n    x: integer;\n";
+    for (int p = 0; p < procedures; p++) {
+        out << "    procedure gp" << p << "(a: integer; b: integer) is\n"
+            << "        total, scratch: integer;\n"
+            << "    begin\n"
+            << "        total := a * 2 + b;\n"
+            << "        scratch := (total - 17) * (a + b) - total;\n"
+            << "        get(total);\n"
+            << "        put(\"result is: \", scratch);\n"
+            << "        putln(total, \" and \", scratch);\n"
+            << "    end gp" << p << ";\n\n";
+    }
+    out << "begin\n    gp1(x, x);\nend bench;\n";
+}
+
+static double Compile(const string& path, bool checkOnly, bool& ok)
+{
+    ParserOptions options;
+    options.checkOnly = checkOnly;
+    remove("check_only_bench_input.tac");
+    remove("check_only_bench_input.asm");
+    ostringstream quiet;
+    streambuf* saved = cout.rdbuf(quiet.rdbuf());
+    auto t0 = chrono::steady_clock::now();
+    {
+        RecursiveDescentParser rdp(path, options);
+    }
+    auto t1 = chrono::steady_clock::now();
+    cout.rdbuf(saved);
+    bool wrote = ifstream("check_only_bench_input.tac").good()
+        || ifstream("check_only_bench_input.asm").good();
+    ok = quiet.str().find("completed successfully") != string::npos && wrote != checkOnly;
+    return chrono::duration<double>(t1 - t0).count();
+}
+
+int main(int argc, char* argv[])
+{
+    int procedures = argc > 1 ? stoi(argv[1]) : 5000;
+    int rounds = argc > 2 ? stoi(argv[2]) : 3;
+    string path = "check_only_bench_input.ada";
+    WriteSource(path, procedures);
+
+    double best[2] = {1e30, 1e30};
+    for (int r = 0; r < rounds; r++) {
+        for (int mode = 0; mode < 2; mode++) {
+            bool ok;
+            best[mode] = min(best[mode], Compile(path, mode == 1, ok));
+            if (!ok) {
+                cout << "Error: " << (mode == 1 ? "check only" : "full compile")
+                     << " run did not behave as expected" << endl;
+                return 1;
+            }
+        }
+    }
+    cout << procedures << " procedures" << endl;
+    cout << "full compile: " << best[0] * 1000 << " ms" << endl;
+    cout << "check only:   " << best[1] * 1000 << " ms (" << best[0] / best[1] << "x)" << endl;
+    remove(path.c_str());
+    remove("check_only_bench_input.tac");
+    remove("check_only_bench_input.asm");
+    return 0;
+}
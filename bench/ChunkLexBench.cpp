@@ -0,0 +1,113 @@
+/*
+ * ChunkLexBench.cpp
+ *
+ * CSC 446 - Compiler Construction - Parallel Tokenize Benchmark
+ *
+ * Author: Landon Dahmen
+ *
+ * Description:
+ *   Generates a multi-megabyte Ada source with a few lexical errors sprinkled
+ *   through it, then pretokenizes it with 1, 2, 4 ... threads. Every thread
+ *   count must give exactly the tokens, offsets and error
+ *   messages that the serial lexer gives; the time for each is reported.
+ *
+ *   Usage: chunk_lex_bench [procedures] [max threads] [rounds]
+ */
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include "../LexicalAnalyzer.h"
+#include "../Globals.h"
+#include "../TokenStream.h"
+
+using namespace std;
+
+thread_local Symbol Token;
+thread_local string_view Lexeme;
+thread_local char ch;
+thread_local int Value;
+thread_local double ValueR;
+thread_local string Literal;
+
+static void WriteSource(const string& path, int procedures)
+{
+    ofstream out(path);
+    out << "procedure bench is\n";
+    for (int p = 0; p < procedures; p++) {
+        out << "    -- generated procedure " << p << ", do not edit by hand\n"
+            << "    procedure gen_proc_" << p << "(in first_value, second_value: integer) is\n"
+            << "        accumulated_total, scratch_value: integer;\n"
+            << "        ratio: constant := 2.75;\n"
+            << "    begin\n"
+            << "        accumulated_total := first_value * 2 + second_value;\n"
+            << "        scratch_value := accumulated_total - 17;\n"
+            << "        put(\"generated procedure result is: \");\n"
+            << "        putln(scratch_value);\n";
+        if (p % 997 == 0) {
+            out << "        put(\"this literal is never closed);\n"
+                << "        identifier_far_too_long_to_keep := 1 # 2;\n";
+        }
+        out << "    end gen_proc_" << p << ";\n\n";
+    }
+    out << "begin\nend bench;\n";
+}
+
+// pretokenize the whole file; returns a checksum over every token field
+static size_t LexAll(const string& path, int threads, size_t& tokens, string& errors)
+{
+    ostringstream diag;
+    LexicalAnalyzer lex(path);
+    lex.SetDiagnostics(diag);
+    TokenStream stream;
+    lex.Tokenize(stream, threads);
+    size_t sum = 0;
+    for (size_t i = 0; i < stream.Size(); i++) {
+        sum = sum * 31 + stream.Kind(i);
+        sum = sum * 31 + stream.Offset(i);
+        sum = sum * 31 + stream.Length(i);
+        sum = sum * 31 + stream.NumValue(i).Value;
+    }
+    tokens = stream.Size();
+    errors = diag.str();
+    return sum;
+}
+
+int main(int argc, char* argv[])
+{
+    int procedures = argc > 1 ? stoi(argv[1]) : 40000;
+    int maxThreads = argc > 2 ? stoi(argv[2]) : max(4u, thread::hardware_concurrency());
+    int rounds = argc > 3 ? stoi(argv[3]) : 3;
+    string path = "chunk_lex_bench_input.ada";
+    WriteSource(path, procedures);
+    cout << "hardware threads: " << thread::hardware_concurrency() << endl;
+
+    size_t reference = 0;
+    string referenceErrors;
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        double best = 1e30;
+        size_t sum = 0, tokens = 0;
+        string errors;
+        for (int r = 0; r < rounds; r++) {
+            auto t0 = chrono::steady_clock::now();
+            sum = LexAll(path, threads, tokens, errors);
+            auto t1 = chrono::steady_clock::now();
+            best = min(best, chrono::duration<double>(t1 - t0).count());
+        }
+        if (threads == 1) {
+            reference = sum;
+            referenceErrors = errors;
+        } else if (sum != reference || errors != referenceErrors) {
+            cout << "Error: " << threads << " threads differ from the serial lexer" << endl;
+            return 1;
+        }
+        cout << threads << " thread(s): " << tokens << " tokens, "
+             << count(errors.begin(), errors.end(), '\n') << " error lines, "
+             << best * 1000 << " ms" << endl;
+    }
+    remove(path.c_str());
+    return 0;
+}
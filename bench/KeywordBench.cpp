@@ -0,0 +1,108 @@
+/*
+ * KeywordBench.cpp
+ *
+ * CSC 446 - Compiler Construction - Keyword Classification Benchmark
+ *
+ * Author: Landon Dahmen
+ *
+ * Description:
+ *   Measures how fast words read from the source can be classified as
+ *   reserved words or identifiers. The old path (two ToLower copies plus
+ *   two probes of a runtime-built unordered_map) is reproduced here and
+ *   timed against FindKeyword from Keywords.h on the same mixed-case word
+ *   list.
+ *
+ *   Usage: keyword_bench [words] [rounds]
+ */
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../Keywords.h"
+
+using namespace std;
+
+static string ToLower(string s)
+{
+    transform(s.begin(), s.end(), s.begin(), ::tolower);
+    return s;
+}
+
+// the classification done by ProcessWordToken before the perfect hash
+static Symbol ClassifyOld(unordered_map<string, Symbol>& reservedWords, const string& word)
+{
+    string temp = ToLower(word);
+    auto it = reservedWords.find(temp);
+    if (it != reservedWords.end()) {
+        Symbol token = reservedWords[temp];
+        string lexeme = ToLower(word);
+        return token;
+    } else if (temp == "real") {
+        return reservedWords["float"];
+    }
+    return idt;
+}
+
+static Symbol ClassifyNew(const string& word)
+{
+    const Keyword* keyword = FindKeyword(word.data(), word.size());
+    return keyword != nullptr ? keyword->token : idt;
+}
+
+int main(int argc, char* argv[])
+{
+    size_t words = argc > 1 ? stoul(argv[1]) : 1000000;
+    int rounds = argc > 2 ? stoi(argv[2]) : 5;
+
+    unordered_map<string, Symbol> reservedWords = {
+        {"begin", begint}, {"module", modulet}, {"constant", constantt},
+        {"procedure", proceduret}, {"is", ist}, {"if", ift}, {"then", thent},
+        {"else", elset}, {"elsif", elsift}, {"while", whilet},
+        {"loop", loopt}, {"float", floatt}, {"integer", integert},
+        {"char", chart}, {"get", gett}, {"put", putt}, {"putln", putlnt}, {"end", endt},
+        {"+", addopt}, {"-", addopt}, {"and", addopt}, {"or", addopt},
+        {"*", mulopt}, {"/", addopt}, {"rem", mulopt}, {"mod", mulopt}, {"and", mulopt},
+        {"in", in}, {"out", out}, {"inout", inout}, {"not", nott}
+    };
+
+    // roughly what generated code looks like: one word in three is reserved,
+    // identifiers are a mix of short names, temporaries and long names
+    const char* samples[] = {
+        "Begin", "counter", "x", "END", "total_sum_value", "put", "idx2",
+        "Integer", "result", "a", "procedure", "temp_17", "loop_count", "is",
+        "PutLn", "accumulator", "i", "REAL", "value", "b12"
+    };
+    vector<string> input;
+    input.reserve(words);
+    for (size_t i = 0; i < words; i++) {
+        input.push_back(samples[(i * 7) % (sizeof(samples) / sizeof(samples[0]))]);
+    }
+
+    double bestOld = 1e30, bestNew = 1e30;
+    size_t checkOld = 0, checkNew = 0;
+    for (int r = 0; r < rounds; r++) {
+        auto t0 = chrono::steady_clock::now();
+        for (const string& w : input) {
+            checkOld += ClassifyOld(reservedWords, w);
+        }
+        auto t1 = chrono::steady_clock::now();
+        for (const string& w : input) {
+            checkNew += ClassifyNew(w);
+        }
+        auto t2 = chrono::steady_clock::now();
+        bestOld = min(bestOld, chrono::duration<double>(t1 - t0).count());
+        bestNew = min(bestNew, chrono::duration<double>(t2 - t1).count());
+    }
+
+    cout << "words per round:        " << words << endl;
+    cout << "unordered_map + ToLower: " << words / bestOld / 1e6 << " M words/s" << endl;
+    cout << "perfect hash:            " << words / bestNew / 1e6 << " M words/s" << endl;
+    cout << "speedup:                 " << bestOld / bestNew << "x" << endl;
+    if (checkOld != checkNew) {
+        cout << "Error: the two classifiers disagree" << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,137 @@
+/*
+ * LoopBench.cpp
+ *
+ * CSC 446 - Compiler Construction - While Loop Benchmark
+ *
+ * Author: Landon Dahmen
+ *
+ * Description:
+ *   Generates a few numeric kernels written as while loops (an n by n
+ *   nest working out row-major offsets, a strided sum and a countdown)
+ *   and compiles each twice: as written (--no-loop-opt), and with loop
+ *   invariant expressions moved out of the loops and the products of the
+ *   loop variables turned into additions. Each .asm is run on AsmMachine;
+ *   the two must write the same output, and the instructions in the code
+ *   and the instructions executed are reported for each.
+ *
+ *   Usage: loop_bench [n]
+ */
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include "AsmMachine.h"
+#include "../Parser.h"
+#include "../Globals.h"
+
+using namespace std;
+
+thread_local Symbol Token;
+thread_local string_view Lexeme;
+thread_local char ch;
+thread_local int Value;
+thread_local double ValueR;
+thread_local string Literal;
+
+// the kernels share a main that sets n and the constants they read
+static void WriteProgram(ostream& out, int n, const string& kernel)
+{
+    out << "procedure bench is\n"
+        << "    n, scale, offset, stride, total: integer;\n"
+        << "    procedure kernel is\n"
+        << "        i, j, k, acc: integer;\n"
+        << "    begin\n"
+        << "        acc := 0;\n"
+        << kernel
+        << "        total := acc;\n"
+        << "    end kernel;\n"
+        << "begin\n"
+        << "    n := " << n << ";\n"
+        << "    scale := 3;\n"
+        << "    offset := 7;\n"
+        << "    stride := 5;\n"
+        << "    kernel();\n"
+        << "    putln(total);\n"
+        << "end bench;\n";
+}
+
+static const char* nest =
+    "        i := 0;\n"
+    "        while i < n loop\n"
+    "            j := 0;\n"
+    "            while j < n loop\n"
+    "                acc := acc + i * n + j * 4 + (scale + offset) * 2;\n"
+    "                j := j + 1;\n"
+    "            end loop;\n"
+    "            i := i + 1;\n"
+    "        end loop;\n";
+
+static const char* strided =
+    "        k := 0;\n"
+    "        while k < n * n loop\n"
+    "            acc := acc + k * stride - scale * offset;\n"
+    "            k := k + 2;\n"
+    "        end loop;\n";
+
+static const char* countdown =
+    "        k := n * n;\n"
+    "        while k > 0 loop\n"
+    "            k := k - 1;\n"
+    "            acc := acc + k * 3 + stride * (k * 6);\n"
+    "        end loop;\n";
+
+static bool CompileAndRun(const string& path, bool optimizeLoops, AsmMachine& machine)
+{
+    ParserOptions options;
+    options.optimizeLoops = optimizeLoops;
+    ostringstream quiet;
+    streambuf* saved = cout.rdbuf(quiet.rdbuf());
+    {
+        RecursiveDescentParser rdp(path, options);
+    }
+    cout.rdbuf(saved);
+    string base = path.substr(0, path.size() - 4);
+    bool ok = quiet.str().find("completed successfully") != string::npos
+        && machine.Load(base + ".asm") && machine.Run();
+    remove((base + ".tac").c_str());
+    remove((base + ".asm").c_str());
+    return ok;
+}
+
+int main(int argc, char* argv[])
+{
+    int n = argc > 1 ? stoi(argv[1]) : 40;
+    struct Kernel {
+        const char* name;
+        const char* code;
+    } kernels[] = {{"n by n nest", nest}, {"strided sum", strided}, {"countdown", countdown}};
+    string path = "loop_bench_input.ada";
+    cout << "n = " << n << endl;
+    cout << setw(14) << "" << setw(24) << "in code" << setw(26) << "executed" << endl;
+    cout << setw(14) << "kernel" << setw(12) << "as written" << setw(12) << "optimised"
+         << setw(14) << "as written" << setw(12) << "optimised" << endl;
+    int failures = 0;
+    for (const Kernel& kernel : kernels) {
+        {
+            ofstream out(path);
+            WriteProgram(out, n, kernel.code);
+        }
+        AsmMachine written, optimised;
+        if (!CompileAndRun(path, false, written) || !CompileAndRun(path, true, optimised)) {
+            cout << setw(14) << kernel.name << ": did not compile and run" << endl;
+            failures++;
+            continue;
+        }
+        if (written.output != optimised.output) {
+            cout << setw(14) << kernel.name << ": the two wrote different output" << endl;
+            failures++;
+            continue;
+        }
+        cout << setw(14) << kernel.name << setw(12) << written.Size() << setw(12) << optimised.Size()
+             << setw(14) << written.executed << setw(12) << optimised.executed << endl;
+    }
+    remove(path.c_str());
+    return failures == 0 ? 0 : 1;
+}
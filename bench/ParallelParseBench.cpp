@@ -0,0 +1,130 @@
+/*
+ * ParallelParseBench.cpp
+ *
+ * CSC 446 - Compiler Construction - Parallel Procedure Compilation Benchmark
+ *
+ * Author: Landon Dahmen
+ *
+ * Description:
+ *   Generates a large Ada program whose outer procedure declares many
+ *   procedures, each with locals, a nested procedure, string literals and
+ *   calls to the procedures before it that pass outer variables. It is
+ *   compiled serially (pretokenized, so only the parsing differs) and then
+ *   with --parse-threads 2, 4, ... up to twice the hardware threads. Every
+ *   run must write the same TAC and assembly as the serial one; the best
+ *   time of each and its speedup are reported next to the number of
+ *   hardware threads, which bounds what can be gained.
+ *
+ *   Usage: parallel_parse_bench [procedures] [rounds]
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../Parser.h"
+#include "../Globals.h"
+
+using namespace std;
+
+thread_local Symbol Token;
+thread_local string_view Lexeme;
+thread_local char ch;
+thread_local int Value;
+thread_local double ValueR;
+thread_local string Literal;
+
+static void WriteSource(const string& path, int procedures)
+{
+    ofstream out(path);
+    out << "procedure bench is\n    x, y: integer;\n    limit: constant := 40;\n";
+    for (int p = 0; p < procedures; p++) {
+        string callee = "gp" + to_string(p > 0 ? p - 1 : 0);
+        out << "    procedure gp" << p << "(a: integer; out b: integer) is\n"
+            << "        total, scratch, count: integer;\n"
+            << "        procedure helper" << p << "(v: integer) is\n"
+            << "            w: integer;\n"
+            << "        begin\n"
+            << "            w := v * 3 + x - limit;\n"
+            << "            putln(\"helper \", w);\n"
+            << "        end helper" << p << ";\n"
+            << "    begin\n"
+            << "        total := a * 2 + b * (x - 7) + limit;\n"
+            << "        scratch := (total - 17) * (a + b) - total * count;\n"
+            << "        count := scratch + total + a + b + x + y;\n"
+            << "        helper" << p << "(total);\n"
+            << "        " << callee << "(y, x, scratch);\n"
+            << "        get(count);\n"
+            << "        put(\"result is: \", scratch, \" and \", count);\n"
+            << "        putln(total);\n"
+            << "    end gp" << p << ";\n\n";
+    }
+    out << "begin\n    gp0(x, y);\nend bench;\n";
+}
+
+static string ReadFile(const string& path)
+{
+    ifstream in(path);
+    stringstream text;
+    text << in.rdbuf();
+    return text.str();
+}
+
+static double Compile(const string& path, int threads, string& tac, string& assembly)
+{
+    ParserOptions options;
+    options.pretokenize = true;
+    options.parseThreads = threads;
+    ostringstream quiet;
+    streambuf* saved = cout.rdbuf(quiet.rdbuf());
+    auto t0 = chrono::steady_clock::now();
+    {
+        RecursiveDescentParser rdp(path, options);
+    }
+    auto t1 = chrono::steady_clock::now();
+    cout.rdbuf(saved);
+    tac = ReadFile("parallel_parse_bench_input.tac");
+    assembly = ReadFile("parallel_parse_bench_input.asm");
+    return chrono::duration<double>(t1 - t0).count();
+}
+
+int main(int argc, char* argv[])
+{
+    int procedures = argc > 1 ? stoi(argv[1]) : 20000;
+    int rounds = argc > 2 ? stoi(argv[2]) : 3;
+    string path = "parallel_parse_bench_input.ada";
+    WriteSource(path, procedures);
+    int cores = max<int>(thread::hardware_concurrency(), 1);
+    vector<int> counts{1};
+    while (counts.back() < cores * 2) {
+        counts.push_back(counts.back() * 2);
+    }
+    cout << procedures << " procedures, hardware threads: " << cores << endl;
+
+    vector<double> best(counts.size(), 1e30);
+    string tac[2], assembly[2];
+    for (int r = 0; r < rounds; r++) {
+        for (size_t c = 0; c < counts.size(); c++) {
+            int slot = c == 0 ? 0 : 1;
+            best[c] = min(best[c], Compile(path, counts[c], tac[slot], assembly[slot]));
+            if (c > 0 && (tac[1] != tac[0] || assembly[1] != assembly[0])) {
+                cout << "Error: output with " << counts[c] << " threads differs from serial" << endl;
+                return 1;
+            }
+        }
+    }
+    cout << setw(8) << "threads" << setw(12) << "ms" << setw(10) << "speedup" << endl;
+    for (size_t c = 0; c < counts.size(); c++) {
+        cout << setw(8) << counts[c] << fixed << setprecision(1) << setw(12) << best[c] * 1000
+             << setprecision(2) << setw(10) << best[0] / best[c] << endl;
+    }
+    remove(path.c_str());
+    remove("parallel_parse_bench_input.tac");
+    remove("parallel_parse_bench_input.asm");
+    return 0;
+}
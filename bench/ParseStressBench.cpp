@@ -0,0 +1,174 @@
+/*
+ * ParseStressBench.cpp
+ *
+ * CSC 446 - Compiler Construction - Long List Parsing Benchmark
+ *
+ * Author: Landon Dahmen
+ *
+ * Description:
+ *   Generates the shapes machine-written programs take and that used to
+ *   cost the parser one native stack frame per element: a body of many
+ *   statements, an expression of many + terms and of many * factors, many
+ *   declarations, a name list of many identifiers, and put and call lists of
+ *   many items. Each is compiled at n, 2n and 4n elements on a thread whose
+ *   stack is only stackKB, so finishing at all shows the stack depth does not
+ *   grow with the list; the time per element at each size shows the parse is
+ *   linear.
+ *
+ *   Usage: parse_stress_bench [n]
+ */
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <pthread.h>
+#include "../Parser.h"
+#include "../Globals.h"
+
+using namespace std;
+
+thread_local Symbol Token;
+thread_local string_view Lexeme;
+thread_local char ch;
+thread_local int Value;
+thread_local double ValueR;
+thread_local string Literal;
+
+const size_t stackKB = 512;
+
+static void Statements(ostream& out, int n)
+{
+    out << "procedure stress is\n    a, b: integer;\nbegin\n";
+    for (int i = 0; i < n; i++) {
+        out << "    a := b;\n";
+    }
+    out << "end stress;\n";
+}
+
+static void Sum(ostream& out, int n)
+{
+    out << "procedure stress is\n    a, b: integer;\nbegin\n    a := b";
+    for (int i = 1; i < n; i++) {
+        out << (i % 16 == 0 ? " +\n    b" : " + b");
+    }
+    out << ";\nend stress;\n";
+}
+
+static void Product(ostream& out, int n)
+{
+    out << "procedure stress is\n    a, b: integer;\nbegin\n    a := b";
+    for (int i = 1; i < n; i++) {
+        out << (i % 16 == 0 ? " *\n    b" : " * b");
+    }
+    out << ";\nend stress;\n";
+}
+
+static void Declarations(ostream& out, int n)
+{
+    out << "procedure stress is\n";
+    for (int i = 0; i < n; i++) {
+        out << "    v" << i << ": integer;\n";
+    }
+    out << "begin\nend stress;\n";
+}
+
+static void NameList(ostream& out, int n)
+{
+    out << "procedure stress is\n    v0";
+    for (int i = 1; i < n; i++) {
+        out << (i % 16 == 0 ? ",\n    v" : ", v") << i;
+    }
+    out << ": integer;\nbegin\nend stress;\n";
+}
+
+static void PutList(ostream& out, int n)
+{
+    out << "procedure stress is\n    a: integer;\nbegin\n    put(a";
+    for (int i = 1; i < n; i++) {
+        out << (i % 16 == 0 ? ",\n    a" : ", a");
+    }
+    out << ");\nend stress;\n";
+}
+
+static void CallList(ostream& out, int n)
+{
+    out << "procedure stress is\n    a: integer;\n"
+        << "    procedure callee is\n    begin\n    end callee;\n"
+        << "begin\n    callee(a";
+    for (int i = 1; i < n; i++) {
+        out << (i % 16 == 0 ? ",\n    a" : ", a");
+    }
+    out << ");\nend stress;\n";
+}
+
+struct Job {
+    string path;
+    bool ok;
+};
+
+static void* Compile(void* argument)
+{
+    Job* job = static_cast<Job*>(argument);
+    ostringstream quiet;
+    streambuf* saved = cout.rdbuf(quiet.rdbuf());
+    {
+        RecursiveDescentParser rdp(job->path);
+    }
+    cout.rdbuf(saved);
+    job->ok = quiet.str().find("completed successfully") != string::npos;
+    return nullptr;
+}
+
+static double CompileOnSmallStack(const string& path, bool& ok)
+{
+    // a stack overflow here would kill the benchmark outright
+    Job job{path, false};
+    pthread_attr_t attributes;
+    pthread_attr_init(&attributes);
+    pthread_attr_setstacksize(&attributes, stackKB * 1024);
+    pthread_t thread;
+    auto start = chrono::steady_clock::now();
+    pthread_create(&thread, &attributes, Compile, &job);
+    pthread_join(thread, nullptr);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    pthread_attr_destroy(&attributes);
+    ok = job.ok;
+    return seconds;
+}
+
+int main(int argc, char* argv[])
+{
+    int n = argc > 1 ? stoi(argv[1]) : 100000;
+    struct Shape {
+        const char* name;
+        function<void(ostream&, int)> write;
+    } shapes[] = {
+        {"statements", Statements}, {"+ terms", Sum}, {"* factors", Product},
+        {"declarations", Declarations}, {"name list", NameList}, {"put items", PutList},
+        {"call arguments", CallList},
+    };
+    string path = "parse_stress_input.ada";
+    cout << "stack " << stackKB << " KB; ns per element at n = " << n << ", 2n and 4n" << endl;
+    int failures = 0;
+    for (const Shape& shape : shapes) {
+        cout << shape.name << ":";
+        for (int scale = 1; scale <= 4; scale *= 2) {
+            {
+                ofstream out(path);
+                shape.write(out, n * scale);
+            }
+            bool ok;
+            double seconds = CompileOnSmallStack(path, ok);
+            cout << "  " << static_cast<long>(seconds * 1e9 / (n * scale)) << (ok ? "" : " (failed)");
+            failures += !ok;
+        }
+        cout << endl;
+    }
+    remove(path.c_str());
+    remove("parse_stress_input.tac");
+    remove("parse_stress_input.asm");
+    return failures == 0 ? 0 : 1;
+}
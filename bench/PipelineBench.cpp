@@ -0,0 +1,104 @@
+/*
+ * PipelineBench.cpp
+ *
+ * CSC 446 - Compiler Construction - Pipelined Lexing Benchmark
+ *
+ * Author: Landon Dahmen
+ *
+ * Description:
+ *   Generates a large Ada program and compiles it with the lexer in
+ *   lockstep with the parser, then with the lexer on its own thread
+ *   (--pipeline). Both runs must write the same TAC and assembly; the time
+ *   for each is reported. The gain depends on having a second core for the
+ *   lexer thread.
+ *
+ *   Usage: pipeline_bench [procedures] [rounds]
+ */
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include "../Parser.h"
+#include "../Globals.h"
+
+using namespace std;
+
+thread_local Symbol Token;
+thread_local string_view Lexeme;
+thread_local char ch;
+thread_local int Value;
+thread_local double ValueR;
+thread_local string Literal;
+
+static void WriteSource(const string& path, int procedures)
+{
+    ofstream out(path);
+    out << "procedure bench is\n    x: integer;\n";
+    for (int p = 0; p < procedures; p++) {
+        out << "    -- generated procedure " << p << ", do not edit by hand\n"
+            << "    procedure gp" << p << "(a: integer; b: integer) is\n"
+            << "        total, scratch: integer;\n"
+            << "    begin\n"
+            << "        total := a * 2 + b;     -- combine inputs\n"
+            << "        scratch := total - 17;  -- adjust\n"
+            << "        put(\"result is: \");\n"
+            << "        putln(scratch);\n"
+            << "    end gp" << p << ";\n\n";
+    }
+    out << "begin\n    gp1(x, x);\nend bench;\n";
+}
+
+static string ReadFile(const string& path)
+{
+    ifstream in(path);
+    stringstream text;
+    text << in.rdbuf();
+    return text.str();
+}
+
+static double Compile(const string& path, bool pipeline, string& tac, string& assembly)
+{
+    ParserOptions options;
+    options.pipeline = pipeline;
+    ostringstream quiet;
+    streambuf* saved = cout.rdbuf(quiet.rdbuf());
+    auto t0 = chrono::steady_clock::now();
+    {
+        RecursiveDescentParser rdp(path, options);
+    }
+    auto t1 = chrono::steady_clock::now();
+    cout.rdbuf(saved);
+    tac = ReadFile("pipeline_bench_input.tac");
+    assembly = ReadFile("pipeline_bench_input.asm");
+    return chrono::duration<double>(t1 - t0).count();
+}
+
+int main(int argc, char* argv[])
+{
+    int procedures = argc > 1 ? stoi(argv[1]) : 5000;
+    int rounds = argc > 2 ? stoi(argv[2]) : 3;
+    string path = "pipeline_bench_input.ada";
+    WriteSource(path, procedures);
+    cout << "hardware threads: " << thread::hardware_concurrency() << endl;
+
+    double best[2] = {1e30, 1e30};
+    string tac[2], assembly[2];
+    for (int r = 0; r < rounds; r++) {
+        for (int mode = 0; mode < 2; mode++) {
+            best[mode] = min(best[mode], Compile(path, mode == 1, tac[mode], assembly[mode]));
+        }
+    }
+    if (tac[0] != tac[1] || assembly[0] != assembly[1]) {
+        cout << "Error: pipelined output differs from lockstep" << endl;
+        return 1;
+    }
+    cout << "lockstep: " << best[0] * 1000 << " ms" << endl;
+    cout << "pipeline: " << best[1] * 1000 << " ms" << endl;
+    remove(path.c_str());
+    remove("pipeline_bench_input.tac");
+    remove("pipeline_bench_input.asm");
+    return 0;
+}
@@ -0,0 +1,137 @@
+/*
+ * RelexBench.cpp
+ *
+ * CSC 446 - Compiler Construction - Incremental Re-lex Benchmark
+ *
+ * Author: Landon Dahmen
+ *
+ * Description:
+ *   Generates a 100k line Ada source and applies a series of random edits
+ *   to it: single characters, whole lines, quotes and comment markers that
+ *   change how the rest of the line lexes, and joins and splits of lines.
+ *   The edits are made first near a wandering cursor, as when typing, then
+ *   anywhere in the file. After each edit the token stream is brought up to
+ *   date with Relex and compared, field by field, against a full Tokenize of
+ *   the edited text. The average time of Relex and of the full re-lex are
+ *   reported.
+ *
+ *   Usage: relex_bench [lines] [edits]
+ */
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include "../LexicalAnalyzer.h"
+#include "../Globals.h"
+#include "../TokenStream.h"
+
+using namespace std;
+
+thread_local Symbol Token;
+thread_local string_view Lexeme;
+thread_local char ch;
+thread_local int Value;
+thread_local double ValueR;
+thread_local string Literal;
+
+static string MakeSource(int lines)
+{
+    ostringstream out;
+    out << "procedure bench is\n";
+    for (int p = 0; lines > 0; p++, lines -= 8) {
+        out << "    -- generated procedure " << p << "\n"
+            << "    procedure gen_proc_" << p << "(in a, b: integer) is\n"
+            << "        total, scratch: integer;\n"
+            << "    begin\n"
+            << "        total := a * 2 + b / 3.5;\n"
+            << "        put(\"result is: \"); putln(total);\n"
+            << "    end gen_proc_" << p << ";\n\n";
+    }
+    out << "begin\nend bench;\n";
+    return out.str();
+}
+
+static bool Same(const TokenStream& a, const TokenStream& b)
+{
+    if (a.Size() != b.Size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.Size(); i++) {
+        if (a.Kind(i) != b.Kind(i) || a.Offset(i) != b.Offset(i) || a.Length(i) != b.Length(i) ||
+            a.NumValue(i).Value != b.NumValue(i).Value ||
+            a.Lexeme(i) != b.Lexeme(i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// apply edits near a wandering cursor (typing) or anywhere in the file
+static bool RunEdits(string& text, TokenStream& tokens, int edits, bool typing, const char* label)
+{
+    const char* snippets[] = {"x", " ", "\n", "\"", "--", "1.5", ":=", "end", "tot", "/=", ";\n  y := 2"};
+    static mt19937 random(446);
+    ostringstream quiet;
+    size_t cursor = text.size() / 2;
+    double relexTime = 0, fullTime = 0;
+    for (int e = 0; e < edits; e++) {
+        TextEdit edit;
+        if (typing) {
+            cursor = min(text.size() - 1, cursor + random() % 161 - 80);
+            edit.offset = cursor;
+        } else {
+            edit.offset = random() % text.size();
+        }
+        edit.removed = min<size_t>(random() % 4, text.size() - edit.offset);
+        edit.inserted = snippets[random() % (sizeof(snippets) / sizeof(snippets[0]))];
+        string edited = text.substr(0, edit.offset) + string(edit.inserted) +
+                        text.substr(edit.offset + edit.removed);
+
+        auto t0 = chrono::steady_clock::now();
+        LexicalAnalyzer lex(edited.data(), edited.size());
+        lex.SetDiagnostics(quiet);
+        lex.Relex(tokens, edit);
+        auto t1 = chrono::steady_clock::now();
+
+        TokenStream full;
+        LexicalAnalyzer fullLex(edited.data(), edited.size());
+        fullLex.SetDiagnostics(quiet);
+        fullLex.Tokenize(full);
+        auto t2 = chrono::steady_clock::now();
+
+        relexTime += chrono::duration<double>(t1 - t0).count();
+        fullTime += chrono::duration<double>(t2 - t1).count();
+        text.swap(edited);
+        tokens.SetSource(text.data());
+        full.SetSource(text.data());
+        if (!Same(tokens, full)) {
+            cout << "Error: " << label << " edit " << e << " at offset " << edit.offset
+                 << " does not match a full re-lex" << endl;
+            return false;
+        }
+    }
+    cout << label << ": " << edits << " edits over " << tokens.Size() << " tokens, relex "
+         << relexTime / edits * 1e6 << " us, full lex " << fullTime / edits * 1e6
+         << " us per edit" << endl;
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    int lines = argc > 1 ? stoi(argv[1]) : 100000;
+    int edits = argc > 2 ? stoi(argv[2]) : 500;
+
+    string text = MakeSource(lines);
+    TokenStream tokens;
+    ostringstream quiet;
+    LexicalAnalyzer lex(text.data(), text.size());
+    lex.SetDiagnostics(quiet);
+    lex.Tokenize(tokens);
+
+    if (!RunEdits(text, tokens, edits, true, "typing") ||
+        !RunEdits(text, tokens, edits, false, "scattered")) {
+        return 1;
+    }
+    return 0;
+}
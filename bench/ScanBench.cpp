@@ -0,0 +1,104 @@
+/*
+ * ScanBench.cpp
+ *
+ * CSC 446 - Compiler Construction - Lexer Scanning Benchmark
+ *
+ * Author: Landon Dahmen
+ *
+ * Description:
+ *   Generates a comment-heavy Ada source (the shape our code generators
+ *   produce), then lexes it to the end with the scalar, SSE2 and AVX2 run
+ *   scanners in turn. Every level must produce the same tokens, lexemes and
+ *   offsets; the time for each level is reported.
+ *
+ *   Usage: scan_bench [procedures] [rounds]
+ */
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include "../LexicalAnalyzer.h"
+#include "../Globals.h"
+#include "../CharScan.h"
+
+using namespace std;
+
+thread_local Symbol Token;
+thread_local string_view Lexeme;
+thread_local char ch;
+thread_local int Value;
+thread_local double ValueR;
+thread_local string Literal;
+
+static void WriteSource(const string& path, int procedures)
+{
+    ofstream out(path);
+    out << "procedure bench is\n";
+    for (int p = 0; p < procedures; p++) {
+        out << "    -- ------------------------------------------------------------\n"
+            << "    -- generated procedure " << p << ", do not edit by hand\n"
+            << "    -- ------------------------------------------------------------\n"
+            << "    procedure gen_proc_" << p << "(in first_value, second_value: integer) is\n"
+            << "        accumulated_total, scratch_value: integer;\n"
+            << "    begin\n"
+            << "        accumulated_total := first_value * 2 + second_value;   -- combine inputs\n"
+            << "        scratch_value := accumulated_total - 17;                -- adjust\n"
+            << "        put(\"generated procedure result is: \");\n"
+            << "        putln(scratch_value);\n"
+            << "    end gen_proc_" << p << ";\n\n";
+    }
+    out << "begin\nend bench;\n";
+}
+
+// lex the whole file; returns a checksum over kinds, lexemes and offsets
+static size_t LexAll(const string& path, size_t& tokens)
+{
+    LexicalAnalyzer lex(path);
+    size_t sum = 0;
+    tokens = 0;
+    lex.GetNextToken();
+    while (Token != eoft) {
+        sum = sum * 31 + Token;
+        sum = sum * 31 + Lexeme.size() + (Lexeme.empty() ? 0 : Lexeme.back());
+        sum = sum * 31 + lex.TokenOffset();
+        tokens++;
+        lex.GetNextToken();
+    }
+    return sum;
+}
+
+int main(int argc, char* argv[])
+{
+    int procedures = argc > 1 ? stoi(argv[1]) : 50000;
+    int rounds = argc > 2 ? stoi(argv[2]) : 3;
+    string path = "scan_bench_input.ada";
+    WriteSource(path, procedures);
+
+    const char* names[] = {"scalar", "SSE2", "AVX2"};
+    size_t reference = 0;
+    for (int level = scanScalar; level <= scanAVX2; level++) {
+        if (SelectScanKernels(static_cast<ScanLevel>(level)) != level) {
+            cout << names[level] << ": not supported on this CPU" << endl;
+            continue;
+        }
+        double best = 1e30;
+        size_t sum = 0, tokens = 0;
+        for (int r = 0; r < rounds; r++) {
+            auto t0 = chrono::steady_clock::now();
+            sum = LexAll(path, tokens);
+            auto t1 = chrono::steady_clock::now();
+            best = min(best, chrono::duration<double>(t1 - t0).count());
+        }
+        if (level == scanScalar) {
+            reference = sum;
+        } else if (sum != reference) {
+            cout << "Error: " << names[level] << " tokens differ from scalar" << endl;
+            return 1;
+        }
+        cout << names[level] << ": " << tokens << " tokens, "
+             << best * 1000 << " ms" << endl;
+    }
+    remove(path.c_str());
+    return 0;
+}
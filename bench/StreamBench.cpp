@@ -0,0 +1,128 @@
+/*
+ * StreamBench.cpp
+ *
+ * CSC 446 - Compiler Construction - Streaming Input Benchmark
+ *
+ * Author: Landon Dahmen
+ *
+ * Description:
+ *   Generates an Ada source with long identifiers, literals and comments,
+ *   then lexes it once from a mapped file and again through the refill
+ *   buffer used for stdin, with buffers from a few bytes (every token
+ *   straddles a refill) up to the default size. Every buffer size must give
+ *   the same tokens, offsets, lexemes and error messages as the mapped file;
+ *   the time for each is reported, along with the peak memory of the
+ *   process, which stays flat because only the buffer holds source text.
+ *
+ *   Usage: stream_bench [procedures]
+ */
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include "../LexicalAnalyzer.h"
+#include "../Globals.h"
+#include "../SourceBuffer.h"
+
+using namespace std;
+
+thread_local Symbol Token;
+thread_local string_view Lexeme;
+thread_local char ch;
+thread_local int Value;
+thread_local double ValueR;
+thread_local string Literal;
+
+static void WriteSource(const string& path, int procedures)
+{
+    ofstream out(path);
+    out << "procedure bench is\n";
+    for (int p = 0; p < procedures; p++) {
+        out << "    -- generated procedure " << p << ", a comment long enough to cross a small buffer\n"
+            << "    procedure gen_proc_" << p << "(in first_value, second_value: integer) is\n"
+            << "        accumulated_total, scratch_value: integer;\n"
+            << "    begin\n"
+            << "        accumulated_total := first_value * 2 + second_value / 12.375;\n"
+            << "        put(\"a generated literal that is longer than the smallest buffers\");\n"
+            << "        putln(scratch_value);--trailing comment\n";
+        if (p % 499 == 0) {
+            out << "        put(\"unterminated);\n"
+                << "        identifier_far_too_long := 1 # 2..3;\n";
+        }
+        out << "    end gen_proc_" << p << ";\n";
+    }
+    out << "begin\nend bench;";      // no newline at the very end
+}
+
+// lex everything; returns a checksum over kinds, offsets and lexeme text
+static size_t LexAll(LexicalAnalyzer& lex, size_t& tokens)
+{
+    size_t sum = 0;
+    tokens = 0;
+    do {
+        lex.GetNextToken();
+        sum = sum * 31 + Token;
+        sum = sum * 31 + lex.TokenOffset();
+        for (char c : Lexeme) {
+            sum = sum * 31 + c;
+        }
+        tokens++;
+    } while (Token != eoft);
+    return sum;
+}
+
+static long PeakKilobytes()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+int main(int argc, char* argv[])
+{
+    int procedures = argc > 1 ? stoi(argv[1]) : 100000;
+    string path = "stream_bench_input.ada";
+    WriteSource(path, procedures);
+
+    // the streamed runs come first so the mapped file does not set the peak
+    long startPeak = PeakKilobytes();
+    size_t sums[8], tokens = 0;
+    string errors[8];
+    size_t sizes[] = {1, 7, 64, 4096, streamBufferSize};
+    int runs = sizeof(sizes) / sizeof(sizes[0]);
+    for (int r = 0; r < runs; r++) {
+        int fd = open(path.c_str(), O_RDONLY);
+        ostringstream diag;
+        LexicalAnalyzer lex(fd, sizes[r]);
+        lex.SetDiagnostics(diag);
+        auto t0 = chrono::steady_clock::now();
+        sums[r] = LexAll(lex, tokens);
+        auto t1 = chrono::steady_clock::now();
+        close(fd);
+        errors[r] = diag.str();
+        cout << "stream, " << sizes[r] << " byte buffer: " << tokens << " tokens, "
+             << chrono::duration<double>(t1 - t0).count() * 1000 << " ms, peak grew "
+             << PeakKilobytes() - startPeak << " KB" << endl;
+    }
+
+    ostringstream diag;
+    LexicalAnalyzer lex(path);
+    lex.SetDiagnostics(diag);
+    auto t0 = chrono::steady_clock::now();
+    size_t reference = LexAll(lex, tokens);
+    auto t1 = chrono::steady_clock::now();
+    cout << "mapped file: " << tokens << " tokens, "
+         << chrono::duration<double>(t1 - t0).count() * 1000 << " ms" << endl;
+    for (int r = 0; r < runs; r++) {
+        if (sums[r] != reference || errors[r] != diag.str()) {
+            cout << "Error: " << sizes[r] << " byte buffer differs from the mapped file" << endl;
+            return 1;
+        }
+    }
+    remove(path.c_str());
+    return 0;
+}
@@ -0,0 +1,217 @@
+/*
+ * SymtabAllocBench.cpp
+ *
+ * CSC 446 - Compiler Construction - Symbol Table Allocation Benchmark
+ *
+ * Author: Landon Dahmen
+ *
+ * Description:
+ *   Drives the symbol table the way the parser does for a program of
+ *   thousands of procedures nested several deep: each procedure is inserted
+ *   in its parent's scope, its parameters, locals and temporaries in its own,
+ *   a string literal now and then at depth 1, and the scope is deleted when
+ *   the procedure ends. The same calls are made on a copy of the original
+ *   table, which allocated each entry with new, and on SymbolTable. A
+ *   replaced global operator new counts the heap allocations each makes, and
+ *   the count of those still live after the table is destroyed shows the
+ *   original's leak.
+ *
+ *   Usage: symtab_alloc_bench [procedures] [nesting]
+ */
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+#include "../SymbolTable.h"
+
+using namespace std;
+
+const int baselineTableSize = 211;
+
+static size_t newCalls = 0;
+static size_t deleteCalls = 0;
+static size_t newBytes = 0;
+
+void* operator new(size_t size)
+{
+    newCalls++;
+    newBytes += size;
+    void* p = malloc(size == 0 ? 1 : size);
+    if (p == nullptr) {
+        throw bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    if (p != nullptr) {
+        deleteCalls++;
+    }
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    operator delete(p);
+}
+
+// the table as it was: a new TableEntry per insert, delete per entry in
+// DeleteDepth, and nothing freed by the destructor
+class BaselineTable {
+    public:
+        struct Entry {
+            string lexeme;
+            Symbol token;
+            int depth;
+            EntryType TypeOfEntry;
+            Entry* next;
+        };
+
+        BaselineTable()
+        {
+            for (int i = 0; i < baselineTableSize; i++) {
+                SymTab[i] = nullptr;
+            }
+        }
+
+        void Insert(string lex, Symbol token, int depth, EntryType type)
+        {
+            int x = hash(lex);
+            Entry* entry = new Entry;
+            entry->token = token;
+            entry->lexeme = lex;
+            entry->depth = depth;
+            entry->TypeOfEntry = type;
+            entry->next = SymTab[x];
+            SymTab[x] = entry;
+        }
+
+        Entry* Lookup(string lex)
+        {
+            for (Entry* entry = SymTab[hash(lex)]; entry != nullptr; entry = entry->next) {
+                if (entry->lexeme == lex) {
+                    return entry;
+                }
+            }
+            return nullptr;
+        }
+
+        void DeleteDepth(int depth)
+        {
+            for (int i = 0; i < baselineTableSize; i++) {
+                Entry* entry = SymTab[i];
+                Entry* prev = nullptr;
+                while (entry != nullptr) {
+                    if (entry->depth == depth && entry->TypeOfEntry != functionEntry) {
+                        Entry* toDelete = entry;
+                        entry = entry->next;
+                        (prev == nullptr ? SymTab[i] : prev->next) = entry;
+                        delete toDelete;
+                    } else {
+                        prev = entry;
+                        entry = entry->next;
+                    }
+                }
+            }
+        }
+
+    private:
+        int hash(const string& lexeme)
+        {
+            unsigned int h = 0, g;
+            for (char c : lexeme) {
+                h = (h << 4) + c;
+                if ((g = h & 0xf0000000)) {
+                    h = h ^ (g >> 24);
+                    h = h ^ g;
+                }
+            }
+            return h % baselineTableSize;
+        }
+
+        Entry* SymTab[baselineTableSize];
+};
+
+struct Names {
+    vector<string> procedures, variables, temps, literals;
+};
+
+// names are made before counting starts and kept short enough that the
+// strings passed by value never allocate
+static Names MakeNames(int procedures)
+{
+    Names names;
+    for (int p = 0; p < procedures; p++) {
+        names.procedures.push_back("p" + to_string(p));
+        names.literals.push_back("_S" + to_string(p));
+    }
+    for (int v = 0; v < 8; v++) {
+        names.variables.push_back("v" + to_string(v));
+    }
+    for (int t = 0; t < 24; t++) {
+        names.temps.push_back("_t" + to_string(t));
+    }
+    return names;
+}
+
+template <typename Table>
+static int Procedure(Table& table, const Names& names, int& next, int depth, int nesting)
+{
+    // one procedure at depth, its own scope at depth + 1
+    int found = 0;
+    const string& name = names.procedures[next];
+    table.Insert(name, idt, depth, functionEntry);
+    for (const string& variable : names.variables) {
+        table.Insert(variable, idt, depth + 1, varEntry);
+    }
+    if (++next < static_cast<int>(names.procedures.size()) && nesting > 1) {
+        found += Procedure(table, names, next, depth + 1, nesting - 1);
+    }
+    for (const string& temp : names.temps) {
+        table.Insert(temp, idt, depth + 1, varEntry);
+        found += table.Lookup(names.variables[temp.size() % names.variables.size()]) != nullptr;
+    }
+    if (next % 4 == 0) {
+        table.Insert(names.literals[next - 1], idt, 1, varEntry);
+    }
+    table.DeleteDepth(depth + 1);
+    return found + (table.Lookup(name) != nullptr);
+}
+
+template <typename Table>
+static void Run(const char* label, const Names& names, int nesting)
+{
+    size_t calls = newCalls, frees = deleteCalls, bytes = newBytes;
+    auto start = chrono::steady_clock::now();
+    int found = 0;
+    {
+        Table table;
+        table.Insert(names.procedures[0], idt, 0, functionEntry);
+        for (int next = 1; next < static_cast<int>(names.procedures.size());) {
+            found += Procedure(table, names, next, 1, nesting);
+        }
+        table.DeleteDepth(1);
+    }
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    calls = newCalls - calls;
+    frees = deleteCalls - frees;
+    cout << label << ": " << calls << " allocations (" << (newBytes - bytes) / 1024 << " KB), "
+         << calls - frees << " still live after destruction, " << ms << " ms"
+         << " [" << found << " lookups hit]" << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    int procedures = argc > 1 ? atoi(argv[1]) : 20000;
+    int nesting = argc > 2 ? atoi(argv[2]) : 16;
+    Names names = MakeNames(procedures);
+    cout << procedures << " procedures nested " << nesting << " deep, "
+         << names.variables.size() << " locals and " << names.temps.size() << " temporaries each"
+         << endl;
+    Run<BaselineTable>("new per entry", names, nesting);
+    Run<SymbolTable>("arena        ", names, nesting);
+    return 0;
+}
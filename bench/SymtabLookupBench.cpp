@@ -0,0 +1,169 @@
+/*
+ * SymtabLookupBench.cpp
+ *
+ * CSC 446 - Compiler Construction - Symbol Table Lookup Benchmark
+ *
+ * Author: Landon Dahmen
+ *
+ * Description:
+ *   Fills a symbol table with a growing number of globals and temporaries
+ *   named the way the parser names them (_t1, _t2, ...), then looks up a
+ *   random mix of declared names and names that were never declared. The
+ *   same names go into a copy of the earlier table (211 chained buckets, the
+ *   PJW hash, string keys passed by value) and into SymbolTable, and the
+ *   lookups per second of each are reported for every table size. SymbolTable
+ *   is timed twice: looked up by name, and by atom as the parser does once
+ *   the lexer has interned the identifier.
+ *
+ *   Usage: symtab_lookup_bench [lookups]
+ */
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <string>
+#include <vector>
+#include "../SymbolTable.h"
+
+using namespace std;
+
+// the table as it was before open addressing
+class ChainedTable {
+    public:
+        ChainedTable()
+        {
+            for (int i = 0; i < bucketCount; i++) {
+                SymTab[i] = nullptr;
+            }
+        }
+
+        ~ChainedTable()
+        {
+            for (int i = 0; i < bucketCount; i++) {
+                while (SymTab[i] != nullptr) {
+                    Entry* next = SymTab[i]->next;
+                    delete SymTab[i];
+                    SymTab[i] = next;
+                }
+            }
+        }
+
+        void Insert(string lex, Symbol token, int depth, EntryType type)
+        {
+            int x = hash(lex);
+            SymTab[x] = new Entry{lex, token, depth, type, SymTab[x]};
+        }
+
+        const void* Lookup(string lex)
+        {
+            for (Entry* entry = SymTab[hash(lex)]; entry != nullptr; entry = entry->next) {
+                if (entry->lexeme == lex) {
+                    return entry;
+                }
+            }
+            return nullptr;
+        }
+
+    private:
+        static const int bucketCount = 211;
+
+        struct Entry {
+            string lexeme;
+            Symbol token;
+            int depth;
+            EntryType TypeOfEntry;
+            Entry* next;
+        };
+
+        int hash(string lexeme)
+        {
+            unsigned int h = 0, g;
+            for (char c : lexeme) {
+                h = (h << 4) + c;
+                if ((g = h & 0xf0000000)) {
+                    h = h ^ (g >> 24);
+                    h = h ^ g;
+                }
+            }
+            return h % bucketCount;
+        }
+
+        Entry* SymTab[bucketCount];
+};
+
+static vector<string> MakeNames(int count)
+{
+    // a tenth declared globals, the rest temporaries
+    vector<string> names;
+    for (int i = 1; i <= count; i++) {
+        names.push_back(i % 10 == 0 ? "global_value_" + to_string(i) : "_t" + to_string(i));
+    }
+    return names;
+}
+
+template <typename Table>
+static double LookupsPerSecond(const vector<string>& names, const vector<string>& probes, int& hits)
+{
+    Table table;
+    for (const string& name : names) {
+        table.Insert(name, idt, 1, varEntry);
+    }
+    hits = 0;
+    auto start = chrono::steady_clock::now();
+    for (const string& probe : probes) {
+        hits += table.Lookup(probe) != nullptr;
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return probes.size() / seconds;
+}
+
+static double AtomLookupsPerSecond(const vector<string>& names, const vector<string>& probes, int& hits)
+{
+    InternTable atoms;
+    SymbolTable table(atoms);
+    for (const string& name : names) {
+        table.Insert(name, idt, 1, varEntry);
+    }
+    // undeclared names are interned too, as the lexer would
+    vector<Atom> probeAtoms;
+    for (const string& probe : probes) {
+        probeAtoms.push_back(atoms.Intern(probe));
+    }
+    hits = 0;
+    auto start = chrono::steady_clock::now();
+    for (Atom probe : probeAtoms) {
+        hits += table.Lookup(probe) != nullptr;
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return probes.size() / seconds;
+}
+
+int main(int argc, char* argv[])
+{
+    int lookups = argc > 1 ? atoi(argv[1]) : 2000000;
+    mt19937 random(446);
+    cout << setw(10) << "symbols" << setw(16) << "chained/s" << setw(16) << "by name/s"
+         << setw(16) << "by atom/s" << endl;
+    for (int count : {100, 1000, 10000, 50000, 200000}) {
+        vector<string> names = MakeNames(count);
+        // nine in ten probes hit
+        vector<string> probes;
+        uniform_int_distribution<int> pick(0, count - 1);
+        for (int i = 0; i < lookups; i++) {
+            probes.push_back(i % 10 == 9 ? "_u" + to_string(pick(random)) : names[pick(random)]);
+        }
+        int chainedHits, openHits, atomHits;
+        double chained = LookupsPerSecond<ChainedTable>(names, probes, chainedHits);
+        double open = LookupsPerSecond<SymbolTable>(names, probes, openHits);
+        double atom = AtomLookupsPerSecond(names, probes, atomHits);
+        if (chainedHits != openHits || openHits != atomHits) {
+            cout << "tables disagree: " << chainedHits << ", " << openHits << " and "
+                 << atomHits << " hits" << endl;
+            return 1;
+        }
+        cout << setw(10) << count << fixed << setprecision(0) << setw(16) << chained
+             << setw(16) << open << setw(16) << atom << endl;
+    }
+    return 0;
+}
@@ -15,6 +15,7 @@
 #include <iostream>
 #include <fstream>
 #include <iomanip>
+#include <cstdlib>
 #include "LexicalAnalyzer.h"
 #include "Globals.h"
 #include "Parser.h"
@@ -22,20 +23,67 @@
 
 using namespace std;
 
-ifstream inputfile;
-Symbol Token;
-string Lexeme;
-char ch;
-int LineNo;
-int Value;
-double ValueR;
-string Literal;
+thread_local Symbol Token;
+thread_local string_view Lexeme;
+thread_local char ch;
+thread_local int Value;
+thread_local double ValueR;
+thread_local string Literal;
 
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
-        cout << "Usage: " << argv[0] << " <filename>" << endl;
+    ParserOptions options;
+    string fileName;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--pretokenize") {
+            options.pretokenize = true;
+        } else if (arg == "--lex-threads" && i + 1 < argc && atoi(argv[i + 1]) > 0) {
+            options.pretokenize = true;
+            options.lexThreads = atoi(argv[++i]);
+        } else if (arg == "--parse-threads" && i + 1 < argc && atoi(argv[i + 1]) > 0) {
+            options.pretokenize = true;
+            options.parseThreads = atoi(argv[++i]);
+        } else if (arg == "--pipeline") {
+            options.pipeline = true;
+        } else if (arg == "--emit-interface") {
+            options.emitInterface = true;
+        } else if (arg == "--max-errors" && i + 1 < argc) {
+            options.maxErrors = atoi(argv[++i]);
+        } else if (arg == "--check-only") {
+            options.checkOnly = true;
+        } else if (arg == "--no-loop-opt") {
+            options.optimizeLoops = false;
+        } else if (arg == "--symtab-stats") {
+            options.symtabStats = true;
+        } else if (arg == "--interface" && i + 1 < argc) {
+            options.interfaces.push_back(argv[++i]);
+        } else if (arg == "-o" && i + 1 < argc) {
+            options.outputBase = argv[++i];
+        } else if (fileName.empty() && arg.compare(0, 2, "--") != 0) {
+            fileName = arg;
+        } else {
+            fileName.clear();
+            break;
+        }
+    }
+    if (fileName.empty()) {
+        cout << "Usage: " << argv[0] << " [--pretokenize | --lex-threads N | --pipeline]"
+             << " [--parse-threads N] [-o base]"
+             << " [--emit-interface] [--interface file.adi]... [--symtab-stats] [--max-errors N]"
+             << " [--check-only] [--no-loop-opt]"
+             << " <filename | ->" << endl;
+        return 1;
+    } else if (fileName == "-" && options.pretokenize) {
+        // stdin is read through a bounded buffer, never held whole
+        cout << "Error: --pretokenize, --lex-threads and --parse-threads need a file, not stdin" << endl;
+        return 1;
+    } else if (options.pipeline && (options.pretokenize || fileName == "-")) {
+        // the lexer thread hands out views into the whole source
+        cout << "Error: --pipeline needs a file and cannot be combined with --pretokenize,"
+             << " --lex-threads or --parse-threads" << endl;
         return 1;
     } else {
-        RecursiveDescentParser rdp(argv[1]);
+        RecursiveDescentParser rdp(fileName, options);
+        return rdp.HadErrors() ? 1 : 0;
     }
 }
\ No newline at end of file
@@ -0,0 +1,34 @@
+/*
+ * RunAsm.cpp
+ *
+ * CSC 446 - Compiler Construction - Generated Assembly Runner
+ *
+ * Author: Landon Dahmen
+ *
+ * Description:
+ *   Runs a .asm written by the compiler on the AsmMachine of the benchmarks
+ *   and prints what the program writes, so the tests can check the code
+ *   generated and not only that it was generated. Exits with 1 if the file
+ *   holds something the machine does not know or the program does not stop.
+ *
+ *   Usage: run_asm file.asm
+ */
+#include <iostream>
+#include "../bench/AsmMachine.h"
+
+using namespace std;
+
+int main(int argc, char* argv[])
+{
+    if (argc != 2) {
+        cout << "Usage: " << argv[0] << " file.asm" << endl;
+        return 1;
+    }
+    AsmMachine machine;
+    if (!machine.Load(argv[1]) || !machine.Run(100000000)) {
+        cout << argv[1] << ": could not be run" << endl;
+        return 1;
+    }
+    cout << machine.output;
+    return 0;
+}
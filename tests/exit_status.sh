@@ -0,0 +1,60 @@
+#!/bin/sh
+#
+# exit_status.sh
+#
+# CSC 446 - Compiler Construction - Exit Status Test
+#
+# Author: Landon Dahmen
+#
+# Description:
+#   Checks what callers such as pre-commit hooks rely on: the compiler exits
+#   with 0 for a program without errors and with 1 for one with errors,
+#   lexical ones included (and for a file that does not exist), with and
+#   without --check-only, and a failed compile leaves no .tac or .asm
+#   behind. A call to a procedure of a library compiled with
+#   --emit-interface is checked against the .adi: the wrong number of
+#   arguments, a number passed out, an argument of the wrong type, or a
+#   procedure name passed as a value is an error.
+#
+#   Usage: tests/exit_status.sh [compiler], run from the top of the tree
+
+compiler=$(realpath "${1:-./compiler}")
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+cp t0.ada tests/errors.ada tests/lexical_error.ada tests/library.ada tests/calls.ada tests/bad_calls.ada tests/name_argument.ada "$work"
+cd "$work" || exit 1
+
+failures=0
+expect() {
+    status=$1
+    shift
+    "$compiler" "$@" > /dev/null
+    actual=$?
+    if [ "$actual" -ne "$status" ]; then
+        echo "FAIL: compiler $* exited with $actual, expected $status"
+        failures=$((failures + 1))
+    fi
+}
+
+expect 0 t0.ada
+expect 0 --check-only t0.ada
+expect 1 errors.ada
+expect 1 --check-only errors.ada
+expect 1 missing.ada
+expect 1 lexical_error.ada
+expect 1 --check-only lexical_error.ada
+expect 1 --pretokenize lexical_error.ada
+expect 1 --pipeline lexical_error.ada
+for base in errors lexical_error; do
+    if [ -e $base.tac ] || [ -e $base.asm ]; then
+        echo "FAIL: $base.ada left output files behind"
+        failures=$((failures + 1))
+    fi
+done
+expect 0 --emit-interface library.ada
+expect 0 --interface library.adi calls.ada
+expect 1 --interface library.adi bad_calls.ada
+expect 1 --interface library.adi name_argument.ada
+
+[ "$failures" -eq 0 ] && echo "exit status: all passed"
+[ "$failures" -eq 0 ]
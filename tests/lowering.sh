@@ -0,0 +1,59 @@
+#!/bin/sh
+#
+# lowering.sh
+#
+# CSC 446 - Compiler Construction - Lowering Regression Test
+#
+# Author: Landon Dahmen
+#
+# Description:
+#   Compiles each program below and checks the code it gets, so a change to
+#   the lowering of if and elsif chains or of while loops cannot slip
+#   through unnoticed: the three address code must match name.tac line for
+#   line, and the .asm, run on the AsmMachine of the benchmarks, must write
+#   name.out. Each is also compiled with --no-loop-opt, which must write the
+#   same, so moving invariants out of loops and reducing products of the
+#   loop variables cannot change what a program does.
+#
+#   Usage: tests/lowering.sh [compiler] [run_asm], run from the top of the
+#   tree
+
+compiler=$(realpath "${1:-./compiler}")
+runner=$(realpath "${2:-tests/run_asm}")
+tests=$(realpath tests)
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+cd "$work" || exit 1
+
+failures=0
+fail() {
+    echo "FAIL: $*"
+    failures=$((failures + 1))
+}
+
+# compile name.ada with the given flags and check what its code writes
+run() {
+    name=$1
+    shift
+    what="$name.ada${*:+ $*}"
+    cp "$tests/$name.ada" .
+    if ! "$compiler" "$@" "$name.ada" > /dev/null; then
+        fail "$what did not compile"
+        return 1
+    fi
+    if ! "$runner" "$name.asm" > "$name.run" || ! cmp -s "$name.run" "$tests/$name.out"; then
+        fail "$what wrote the wrong output"
+        return 1
+    fi
+}
+
+for name in branches loops; do
+    run $name --no-loop-opt
+    if run $name && ! cmp -s $name.tac "$tests/$name.tac"; then
+        fail "$name.ada gave different three address code"
+        diff "$tests/$name.tac" $name.tac | head -20
+    fi
+done
+
+[ "$failures" -eq 0 ] && echo "lowering: all passed"
+[ "$failures" -eq 0 ]